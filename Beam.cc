@@ -0,0 +1,162 @@
+/******************************************************************************************[Beam.cc]
+GenPCE -- Copyright (c) 2016, Ruben Martins, Martin Brain, Liana Hadarean, Daniel Kroening
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************/
+
+
+#include "GenPCE.h"
+
+// Beam search over sets of auxiliary variables.
+//
+// The greedy search commits to the single best variable of each iteration
+// and stops when no variable makes the encoding smaller. The beam search
+// keeps the 'beam_width' best sets of each level instead, and extends each
+// of them with every other variable at the next level, so a variable that
+// only pays off together with another one is not missed. Every set is
+// evaluated once, from the first state of the beam that it extends, and the
+// evaluation starts from the minimal encoding of that state (see
+// 'evaluateCandidate'). The evaluations of a level run on 'threads' threads,
+// and the states are ranked by cost and then by their variables, so the
+// result does not depend on the number of threads.
+
+void GenPCE::beamSearch() {
+  printStats("reference encoding", reference);
+
+  std::vector<bool> is_input(reference->nVars(), false);
+  for (int i = 0; i < inputs.size(); i++)
+    is_input[Minisat::var(inputs[i])] = true;
+
+  buildOptimal(false);
+  if (stopRequested()) {
+    printInterrupted();
+    minimize(optimal, true);
+    return;
+  }
+
+  std::vector<beam_state> beam(1);
+  beam[0].cost = minimize(optimal, false, &beam[0].pool);
+  beam_state best = beam[0];
+  std::cout << "c Beam level: 0\t MinCls: " << best.cost << "\t States: 1" << std::endl;
+
+  for (int level = 1; beam_depth == 0 || level <= beam_depth; level++) {
+    std::vector<beam_task> tasks;
+    std::set<StdVec> generated;
+    for (unsigned s = 0; s < beam.size(); s++) {
+      for (Var v = 0; v < reference->nVars(); v++) {
+        Lit p = Minisat::mkLit(v, false);
+        const StdVec &aux = beam[s].aux;
+        if (is_input[v] || std::find(aux.begin(), aux.end(), p) != aux.end())
+          continue;
+
+        beam_task t;
+        t.state = s;
+        t.v = v;
+        t.child.aux = aux;
+        t.child.aux.push_back(p);
+        std::sort(t.child.aux.begin(), t.child.aux.end());
+        t.child.cost = -1;
+        if (generated.insert(t.child.aux).second)
+          tasks.push_back(t);
+      }
+    }
+    if (tasks.empty())
+      break;
+
+    greedy_next = 0;
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; t++)
+      pool.push_back(std::thread(&GenPCE::beamWorker, this, &beam, &tasks));
+    for (unsigned t = 0; t < pool.size(); t++)
+      pool[t].join();
+
+    std::vector<beam_state> next;
+    for (unsigned i = 0; i < tasks.size(); i++) {
+      if (tasks[i].child.cost < 0)
+        continue;
+      next.push_back(beam_state());
+      next.back().aux.swap(tasks[i].child.aux);
+      next.back().cost = tasks[i].child.cost;
+      next.back().pool.swap(tasks[i].child.pool);
+    }
+    std::sort(next.begin(), next.end());
+    if ((int)next.size() > beam_width)
+      next.resize(beam_width);
+    if (next.empty())
+      break;
+
+    std::cout << "c Beam level: " << level << "\t MinCls: " << next[0].cost 
+              << "\t States: " << next.size() << std::endl;
+    bool improved = next[0].cost < best.cost;
+    if (improved)
+      best = next[0];
+    beam.swap(next);
+    if ((beam_depth == 0 && !improved) || stopRequested())
+      break;
+  }
+
+  // Every state of the beam has a complete encoding, even after a stop
+  if (stopRequested())
+    std::cout << "c :: interrupted :: " << stop_reason << std::endl;
+  std::cout << "c i";
+  for (int i = 0 ; i < inputs.size(); i++)
+    std::cout << " " << Minisat::var(inputs[i])+1;
+  for (unsigned i = 0 ; i < best.aux.size(); i++)
+    std::cout << " " << Minisat::var(best.aux[i])+1;
+  std::cout << " 0" << std::endl;
+
+  std::cout << "c aux";
+  for (unsigned i = 0 ; i < best.aux.size(); i++)
+    std::cout << " " << Minisat::var(best.aux[i])+1;
+  std::cout << std::endl;
+  std::cout << "c :: reused cubes :: " << n_reused_cubes << std::endl;
+
+  Solver *encoding = acquireSolver(optimal->nVars());
+  seedEncoding(encoding, best.pool);
+  streamClauses(best.pool);
+  minimize(encoding, true);
+  releaseSolver(encoding);
+}
+
+void GenPCE::beamWorker(const std::vector<beam_state> *beam, std::vector<beam_task> *tasks) {
+  for (;;) {
+    unsigned i;
+    {
+      std::lock_guard<std::mutex> guard(greedy_lock);
+      if (stop_reason != NULL || greedy_next >= tasks->size())
+        return;
+      i = greedy_next++;
+    }
+
+    beam_task &t = (*tasks)[i];
+    const beam_state &s = (*beam)[t.state];
+    MinVec base;
+    inputs.copyTo(base);
+    for (unsigned j = 0; j < s.aux.size(); j++)
+      base.push(s.aux[j]);
+
+    Solver *encoding = NULL;
+    t.child.cost = evaluateCandidate(base, s.pool, t.v, encoding, NULL, &t.child.pool);
+    releaseSolver(encoding);
+  }
+}
@@ -0,0 +1,272 @@
+/************************************************************************************[Checkpoint.cc]
+GenPCE -- Copyright (c) 2016, Ruben Martins, Martin Brain, Liana Hadarean, Daniel Kroening
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************/
+
+#include "GenPCE.h"
+#include <stdio.h>
+
+// Checkpoint file layout (native endianness, all counts are 32-bit):
+//
+//   magic, version, reference variables, reference clauses
+//   assignments analyzed
+//   greedy state: iteration, cost, begin_cost, pos, candidate,
+//                 aux_vars, copy_inputs, aux_inputs, clause pool
+//   inputs
+//   optimal encoding: variables, units, clauses
+//   frontier: (core, pa) for each assignment in 'assignment_heap'
+//   cube store ('db_assignments')
+//
+// Literals are stored with Minisat::toInt and every list is preceded by its
+// size. A resumed file is not trusted: every size must fit in the rest of the
+// file and every literal must be a variable of the reference.
+
+static const int32_t checkpoint_magic = 0x45435047; // "GPCE"
+static const int32_t checkpoint_version = 2;
+
+namespace {
+
+struct Writer {
+  FILE* f;
+  bool ok;
+  Writer(FILE* _f) : f(_f), ok(f != NULL) {}
+
+  void put(int32_t x) { ok = ok && fwrite(&x, sizeof(x), 1, f) == 1; }
+  void put(const StdVec& v) {
+    put((int32_t)v.size());
+    for (unsigned i = 0; i < v.size(); i++) put(Minisat::toInt(v[i]));
+  }
+  void put(const MinVec& v) {
+    put(v.size());
+    for (int i = 0; i < v.size(); i++) put(Minisat::toInt(v[i]));
+  }
+};
+
+struct Reader {
+  FILE* f;
+  bool ok;
+  long left;      // Bytes not read yet
+  int n_vars;     // Variables of the reference
+  Reader(FILE* _f, int _n_vars) : f(_f), ok(f != NULL), left(0), n_vars(_n_vars) {
+    ok = ok && fseek(f, 0, SEEK_END) == 0 && (left = ftell(f)) >= 0 && fseek(f, 0, SEEK_SET) == 0;
+  }
+
+  int32_t get() {
+    int32_t x = 0;
+    ok = ok && fread(&x, sizeof(x), 1, f) == 1;
+    left -= sizeof(x);
+    return x;
+  }
+  // Size of a list whose items take at least 'item' bytes each
+  int32_t count(long item = sizeof(int32_t)) {
+    int32_t n = get();
+    ok = ok && n >= 0 && n <= left / item;
+    return ok ? n : 0;
+  }
+  Minisat::Lit lit() {
+    int32_t x = get();
+    ok = ok && x >= 0 && x < 2 * n_vars;
+    return Minisat::toLit(ok ? x : 0);
+  }
+  void get(StdVec& v) {
+    int32_t n = count();
+    v.clear();
+    for (int i = 0; i < n && ok; i++) v.push_back(lit());
+  }
+  void get(MinVec& v) {
+    int32_t n = count();
+    v.clear();
+    for (int i = 0; i < n && ok; i++) v.push(lit());
+  }
+};
+
+// The saved inputs must be the inputs of the reference, followed in the
+// greedy mode by distinct auxiliary variables
+static bool extendsInputs(const MinVec& saved, const MinVec& given, int n_vars, bool greedy) {
+  if (saved.size() < given.size() || (!greedy && saved.size() != given.size()))
+    return false;
+  std::vector<bool> seen(n_vars, false);
+  for (int i = 0; i < saved.size(); i++) {
+    Minisat::Var v = Minisat::var(saved[i]);
+    if ((i < given.size() && saved[i] != given[i]) || seen[v])
+      return false;
+    seen[v] = true;
+  }
+  return true;
+}
+
+}
+
+void GenPCE::writeCheckpoint() {
+  std::string tmp = checkpoint_file + ".tmp";
+  Writer w(fopen(tmp.c_str(), "wb"));
+
+  w.put(checkpoint_magic);
+  w.put(checkpoint_version);
+  w.put(reference->nVars());
+  w.put(reference->nClauses());
+  w.put((int32_t)n_assignments);
+
+  w.put(greedy ? 1 : 0);
+  if (greedy) {
+    w.put(iteration);
+    w.put(cost);
+    w.put(begin_cost);
+    w.put(pos);
+    w.put(candidate);
+    w.put((int32_t)aux_vars.size());
+    for (unsigned i = 0; i < aux_vars.size(); i++) w.put(aux_vars[i] ? 1 : 0);
+    w.put(copy_inputs);
+    w.put(aux_inputs);
+    w.put((int32_t)greedy_pool.size());
+    for (unsigned i = 0; i < greedy_pool.size(); i++)
+      w.put(greedy_pool[i]);
+  }
+
+  w.put(inputs);
+
+  // Clauses learned by parallel workers are not merged into 'optimal' until
+  // the end of the search
+  MinVec units;
+  MinVec clause;
+  optimal->getUnits(units);
+  w.put(optimal->nVars());
+  w.put(units);
+  w.put((int32_t)(optimal->nClauses() + shared_clauses.size()));
+  for (int i = 0; i < optimal->nClauses(); i++) {
+    clause.clear();
+    optimal->getClause(i, clause);
+    w.put(clause);
+  }
+  for (unsigned i = 0; i < shared_clauses.size(); i++)
+    w.put(shared_clauses[i]);
+
+  std::priority_queue<assignment, std::vector<assignment>, GreaterThanBySize> 
+    frontier = assignment_heap;
+  w.put((int32_t)frontier.size());
+  while (!frontier.empty()) {
+    w.put(frontier.top().core);
+    w.put(frontier.top().pa);
+    frontier.pop();
+  }
+
+  w.ok = w.ok && db_assignments.write(w.f);
+  if (w.f != NULL && fclose(w.f) != 0) w.ok = false;
+
+  if (!w.ok || rename(tmp.c_str(), checkpoint_file.c_str()) != 0)
+    std::cerr << "Could not write checkpoint : " << checkpoint_file << std::endl;
+  else if (print)
+    std::cout << "c :: checkpoint :: " << checkpoint_file 
+              << " :: frontier :: " << assignment_heap.size() << std::endl;
+
+  last_checkpoint = time(NULL);
+}
+
+bool GenPCE::resume(const char* file) {
+  FILE* f = fopen(file, "rb");
+  Reader r(f, reference->nVars());
+  MinVec given;
+  inputs.copyTo(given);
+
+  if (r.get() != checkpoint_magic || r.get() != checkpoint_version ||
+      r.get() != reference->nVars() || r.get() != reference->nClauses()) {
+    if (f != NULL) fclose(f);
+    return false;
+  }
+  n_assignments = r.get();
+
+  if (r.get() != (greedy ? 1 : 0)) {
+    fclose(f);
+    return false;
+  }
+  if (greedy) {
+    iteration = r.get();
+    cost = r.get();
+    begin_cost = r.get();
+    pos = r.get();
+    candidate = r.get();
+    r.ok = r.ok && pos >= 0 && pos < reference->nVars() &&
+      candidate >= GREEDY_LAST && candidate <= reference->nVars();
+    aux_vars.resize(r.count());
+    r.ok = r.ok && (int)aux_vars.size() == reference->nVars();
+    for (unsigned i = 0; i < aux_vars.size() && r.ok; i++) aux_vars[i] = r.get();
+    r.get(copy_inputs);
+    r.ok = r.ok && extendsInputs(copy_inputs, given, reference->nVars(), true);
+    r.get(aux_inputs);
+    greedy_pool.resize(r.count());
+    for (unsigned i = 0; i < greedy_pool.size() && r.ok; i++)
+      r.get(greedy_pool[i]);
+    complete_inputs.clear();
+    if (!r.ok) {
+      fclose(f);
+      return false;
+    }
+    if (!greedy_pool.empty())
+      markComplete(copy_inputs);
+  }
+
+  r.get(inputs);
+  r.ok = r.ok && extendsInputs(inputs, given, reference->nVars(), greedy);
+  db_assignments.init(inputs);
+  std::vector<bool> is_input(reference->nVars(), false);
+  for (int i = 0; i < inputs.size() && r.ok; i++)
+    is_input[Minisat::var(inputs[i])] = true;
+
+  optimal = acquireSolver(0);
+  int n_vars = r.get();
+  r.ok = r.ok && n_vars >= 0 && n_vars <= reference->nVars();
+  while (optimal->nVars() < n_vars && r.ok)
+    optimal->newVar();
+  r.n_vars = optimal->nVars();
+
+  MinVec clause;
+  r.get(clause);
+  for (int i = 0; i < clause.size(); i++)
+    optimal->addClause(clause[i]);
+  int n_clauses = r.count();
+  for (int i = 0; i < n_clauses && r.ok; i++) {
+    r.get(clause);
+    optimal->addClause(clause);
+  }
+
+  while (!assignment_heap.empty())
+    assignment_heap.pop();
+  r.n_vars = reference->nVars();
+  int n_frontier = r.count(2 * sizeof(int32_t));
+  for (int i = 0; i < n_frontier && r.ok; i++) {
+    assignment a;
+    r.get(a.core);
+    r.get(a.pa);
+    // The cube store only knows the inputs
+    for (unsigned j = 0; j < a.core.size() && r.ok; j++)
+      r.ok = is_input[Minisat::var(a.core[j])];
+    assignment_heap.push(a);
+  }
+
+  r.ok = r.ok && db_assignments.read(f);
+  fclose(f);
+
+  resumed = r.ok;
+  return r.ok;
+}
@@ -0,0 +1,90 @@
+/************************************************************************************[ClauseSink.cc]
+GenPCE -- Copyright (c) 2016, Ruben Martins, Martin Brain, Liana Hadarean, Daniel Kroening
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************/
+
+#include "ClauseSink.h"
+
+bool ClauseSink::open(const char* file, bool append) {
+  close();
+  out = fopen(file, append ? "ab" : "wb");
+  buffer.reserve(buffer_size);
+  last_flush = time(NULL);
+  return out != NULL;
+}
+
+void ClauseSink::close() {
+  if (out == NULL)
+    return;
+  flush();
+  // A failed write has already closed the file
+  std::lock_guard<std::mutex> guard(lock);
+  if (out != NULL)
+    fclose(out);
+  out = NULL;
+}
+
+void ClauseSink::add(const Minisat::vec<Minisat::Lit>& clause) {
+  char lit[16];
+  std::lock_guard<std::mutex> guard(lock);
+  if (out == NULL)
+    return;
+
+  for (int i = 0; i < clause.size(); i++) {
+    int n = snprintf(lit, sizeof(lit), "%s%d ", Minisat::sign(clause[i]) ? "-" : "",
+                     Minisat::var(clause[i]) + 1);
+    buffer.append(lit, n);
+  }
+  buffer.append("0\n");
+  n_clauses++;
+
+  if (buffer.size() >= buffer_size || time(NULL) != last_flush)
+    write();
+}
+
+void ClauseSink::flush() {
+  std::lock_guard<std::mutex> guard(lock);
+  if (out != NULL)
+    write();
+}
+
+// Writes the buffer if it holds clauses older than a second
+void ClauseSink::tick() {
+  std::lock_guard<std::mutex> guard(lock);
+  if (out != NULL && !buffer.empty() && time(NULL) != last_flush)
+    write();
+}
+
+// Assumes 'lock' is held
+void ClauseSink::write() {
+  bool ok = fwrite(buffer.data(), 1, buffer.size(), out) == buffer.size();
+  ok = fflush(out) == 0 && ok;
+  buffer.clear();
+  last_flush = time(NULL);
+  if (!ok) {
+    fprintf(stderr, "Could not write to stream, the clauses are no longer streamed\n");
+    fclose(out);
+    out = NULL;
+  }
+}
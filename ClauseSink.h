@@ -0,0 +1,67 @@
+/*************************************************************************************[ClauseSink.h]
+GenPCE -- Copyright (c) 2016, Ruben Martins, Martin Brain, Liana Hadarean, Daniel Kroening
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************/
+
+#ifndef ClauseSink_h
+#define ClauseSink_h
+
+#include "core/Solver.h"
+#include <stdio.h>
+#include <ctime>
+#include <string>
+#include <mutex>
+
+// Appends clauses in DIMACS format to a file or pipe while the search runs.
+// Clauses are formatted into a buffer that is written (and flushed) when it
+// is full or, through 'add' and 'tick', when it is older than a second. The
+// sink is closed after the first failed write (e.g. the reader of a pipe is
+// gone), which is reported once on stderr.
+class ClauseSink {
+ public:
+  ClauseSink() : out(NULL), last_flush(0), n_clauses(0) {}
+  ~ClauseSink() { close(); }
+
+  bool open(const char* file, bool append);
+  void close();
+
+  void add(const Minisat::vec<Minisat::Lit>& clause);
+  void flush();
+  void tick();
+
+  unsigned size() const { return n_clauses; }
+
+ protected:
+  void write();
+
+  FILE* out;
+  std::string buffer;
+  time_t last_flush;
+  unsigned n_clauses;
+  std::mutex lock;
+
+  static const size_t buffer_size = 1 << 16;
+};
+
+#endif
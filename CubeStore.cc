@@ -0,0 +1,187 @@
+/*************************************************************************************[CubeStore.cc]
+GenPCE -- Copyright (c) 2016, Ruben Martins, Martin Brain, Liana Hadarean, Daniel Kroening
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************/
+
+#include "CubeStore.h"
+
+static uint64_t splitmix(uint64_t& x) {
+  uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+void CubeStore::init(const Minisat::vec<Minisat::Lit>& inputs) {
+  index.clear();
+  int n_inputs = 0;
+  for (int i = 0; i < inputs.size(); i++) {
+    Minisat::Var v = Minisat::var(inputs[i]);
+    if ((int)index.size() <= v) index.resize(v+1, -1);
+    if (index[v] == -1) index[v] = n_inputs++;
+  }
+
+  n_words = (2 * n_inputs + 63) / 64;
+  if (n_words == 0) n_words = 1;
+
+  uint64_t seed = 0;
+  keys.resize(2 * n_inputs);
+  for (unsigned i = 0; i < keys.size(); i++)
+    keys[i] = splitmix(seed);
+
+  clear();
+}
+
+void CubeStore::clear() {
+  n_cubes = 0;
+  arena.clear();
+  table.assign(1024, 0);
+}
+
+uint64_t CubeStore::encode(const StdVec& core, uint64_t* cube) const {
+  uint64_t hash = 0;
+  for (int i = 0; i < n_words; i++)
+    cube[i] = 0;
+
+  for (unsigned i = 0; i < core.size(); i++) {
+    int pos = position(core[i]);
+    cube[pos / 64] |= 1ULL << (pos % 64);
+    if (Minisat::sign(core[i])) cube[pos / 64] |= 2ULL << (pos % 64);
+    hash ^= key(core[i]);
+  }
+  return hash;
+}
+
+uint64_t CubeStore::rehash(const uint64_t* cube) const {
+  uint64_t hash = 0;
+  for (int i = 0; i < n_words; i++) {
+    uint64_t assigned = cube[i] & 0x5555555555555555ULL;
+    while (assigned != 0) {
+      int bit = __builtin_ctzll(assigned);
+      hash ^= keys[i * 64 + bit + ((cube[i] >> (bit + 1)) & 1)];
+      assigned &= assigned - 1;
+    }
+  }
+  return hash;
+}
+
+void CubeStore::rebuild(size_t slots) {
+  table.assign(slots, 0);
+  uint32_t mask = table.size() - 1;
+  for (unsigned i = 0; i < n_cubes; i++) {
+    uint32_t slot = rehash(&arena[i * n_words]) & mask;
+    while (table[slot] != 0)
+      slot = (slot + 1) & mask;
+    table[slot] = i + 1;
+  }
+}
+
+// Returns the slot of the cube 'cube' extended with 'p', or the empty slot
+// where it would be inserted
+uint32_t CubeStore::probe(const uint64_t* cube, uint64_t hash, Minisat::Lit p) const {
+  int pos = position(p);
+  int p_word = pos / 64;
+  uint64_t p_bits = (Minisat::sign(p) ? 3ULL : 1ULL) << (pos % 64);
+  hash ^= key(p);
+
+  uint32_t mask = table.size() - 1;
+  uint32_t slot = hash & mask;
+  while (table[slot] != 0) {
+    const uint64_t* other = &arena[(table[slot] - 1) * n_words];
+    bool equal = true;
+    for (int i = 0; i < n_words && equal; i++)
+      equal = other[i] == (i == p_word ? cube[i] | p_bits : cube[i]);
+    if (equal)
+      break;
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}
+
+bool CubeStore::insert(const uint64_t* cube, uint64_t hash, Minisat::Lit p) {
+  uint32_t slot = probe(cube, hash, p);
+  if (table[slot] != 0)
+    return false;
+
+  int pos = position(p);
+  int p_word = pos / 64;
+  uint64_t p_bits = (Minisat::sign(p) ? 3ULL : 1ULL) << (pos % 64);
+  for (int i = 0; i < n_words; i++)
+    arena.push_back(i == p_word ? cube[i] | p_bits : cube[i]);
+  table[slot] = ++n_cubes;
+
+  // Keep the load factor of the table below 1/2
+  if (2 * n_cubes > table.size())
+    rebuild(table.size() * 2);
+  return true;
+}
+
+bool CubeStore::contains(const uint64_t* cube, uint64_t hash, Minisat::Lit p) const {
+  return table[probe(cube, hash, p)] != 0;
+}
+
+bool CubeStore::write(FILE* f) const {
+  int32_t header[2] = { n_words, (int32_t)n_cubes };
+  return fwrite(header, sizeof(int32_t), 2, f) == 2 &&
+    fwrite(arena.data(), sizeof(uint64_t), arena.size(), f) == arena.size();
+}
+
+bool CubeStore::read(FILE* f) {
+  int32_t header[2];
+  if (fread(header, sizeof(int32_t), 2, f) != 2 || header[0] != n_words)
+    return false;
+
+  // The cubes must fit in the rest of the file
+  long at = ftell(f);
+  if (header[1] < 0 || at < 0 || fseek(f, 0, SEEK_END) != 0)
+    return false;
+  long left = ftell(f) - at;
+  if (fseek(f, at, SEEK_SET) != 0 || (uint64_t)header[1] * n_words * sizeof(uint64_t) > (uint64_t)left)
+    return false;
+
+  n_cubes = header[1];
+  arena.resize((size_t)n_cubes * n_words);
+  if (fread(arena.data(), sizeof(uint64_t), arena.size(), f) != arena.size()) {
+    clear();
+    return false;
+  }
+
+  // Every sign bit needs its assigned bit, and the bits past the last input
+  // must be clear
+  int n_bits = keys.size() - 64 * (n_words - 1);
+  uint64_t last = n_bits >= 64 ? ~0ULL : (1ULL << n_bits) - 1;
+  for (size_t i = 0; i < arena.size(); i++) {
+    uint64_t w = arena[i];
+    bool stray = (i % n_words == (size_t)n_words - 1) && (w & ~last) != 0;
+    if (stray || ((w >> 1) & ~w & 0x5555555555555555ULL) != 0) {
+      clear();
+      return false;
+    }
+  }
+
+  size_t slots = 1024;
+  while (2 * n_cubes > slots) slots *= 2;
+  rebuild(slots);
+  return true;
+}
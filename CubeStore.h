@@ -0,0 +1,88 @@
+/**************************************************************************************[CubeStore.h]
+GenPCE -- Copyright (c) 2016, Ruben Martins, Martin Brain, Liana Hadarean, Daniel Kroening
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************/
+
+#ifndef CubeStore_h
+#define CubeStore_h
+
+#include "core/Solver.h"
+#include <vector>
+#include <stdint.h>
+#include <stdio.h>
+
+typedef std::vector<Minisat::Lit> StdVec;
+
+// Set of cubes (partial assignments) over a fixed set of input variables.
+//
+// Every cube is stored in a flat arena as 'width()' 64-bit words with two bits
+// per input (assigned, negative). The arena is indexed by an open-addressing
+// hash table, and the hash of a cube is the xor of the keys of its literals so
+// that the hash of a child cube is obtained from the hash of its parent.
+class CubeStore {
+ public:
+  CubeStore() : n_words(0), n_cubes(0) {}
+
+  // Maps the input variables to bit positions and removes all cubes
+  void init(const Minisat::vec<Minisat::Lit>& inputs);
+  void clear();
+
+  // Encodes 'core' into 'cube' (an array of 'width()' words) and returns its hash
+  uint64_t encode(const StdVec& core, uint64_t* cube) const;
+
+  // Inserts the cube 'cube' extended with 'p'. Returns false if it was already
+  // in the store. 'hash' must be the value returned by 'encode' for 'cube'.
+  bool insert(const uint64_t* cube, uint64_t hash, Minisat::Lit p);
+  // Returns true if the cube 'cube' extended with 'p' is in the store
+  bool contains(const uint64_t* cube, uint64_t hash, Minisat::Lit p) const;
+
+  // Binary (de)serialization of the stored cubes, used by checkpoints. The
+  // store must have been initialized with the same inputs before 'read'.
+  bool write(FILE* f) const;
+  bool read(FILE* f);
+
+  int width() const { return n_words; }
+  unsigned size() const { return n_cubes; }
+  size_t bytes() const { 
+    return arena.capacity() * sizeof(uint64_t) + table.capacity() * sizeof(uint32_t); 
+  }
+
+ protected:
+  int position(Minisat::Lit p) const { return 2 * index[Minisat::var(p)]; }
+  uint64_t key(Minisat::Lit p) const { 
+    return keys[position(p) + (Minisat::sign(p) ? 1 : 0)]; 
+  }
+  uint32_t probe(const uint64_t* cube, uint64_t hash, Minisat::Lit p) const;
+  uint64_t rehash(const uint64_t* cube) const;
+  void rebuild(size_t slots);
+
+  int n_words;
+  unsigned n_cubes;
+  std::vector<int> index;         // Input position of each variable (-1 if not an input)
+  std::vector<uint64_t> keys;     // Random key of each input literal
+  std::vector<uint64_t> arena;    // Cube encodings, 'n_words' words each
+  std::vector<uint32_t> table;    // Open-addressing index into 'arena' (0 means empty)
+};
+
+#endif
@@ -25,6 +25,36 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 ************************************************************************************************/
 
 #include "GenPCE.h"
+#include "utils/System.h"
+
+using Minisat::lbool;
+
+volatile sig_atomic_t GenPCE::stop_signal = 0;
+std::mutex GenPCE::random_lock;
+
+// Checks the signal flag and the resource limits. Once the search is stopped
+// it stays stopped.
+bool GenPCE::stopRequested() {
+  if (stop_reason != NULL)
+    return true;
+
+  time_t now = time(NULL);
+  if (stop_signal)
+    stop_reason = "signal";
+  else if (time_limit > 0 && now - start_time >= time_limit)
+    stop_reason = "time limit";
+  else if (mem_limit > 0 && now != last_mem_check) {
+    last_mem_check = now;
+    if (Minisat::memUsed() >= mem_limit)
+      stop_reason = "memory limit";
+  }
+  return stop_reason != NULL;
+}
+
+void GenPCE::printInterrupted() {
+  std::cout << "c :: interrupted :: " << stop_reason << std::endl;
+  std::cout << "c :: unexplored assignments :: " << assignment_heap.size() << std::endl;
+}
 
 void GenPCE::printVec(const std::string type, 
 			     const MinVec &pa, 
@@ -85,98 +115,225 @@ bool GenPCE::propagate(Minisat::Solver* s, const StdVec& pa) {
   return res;
 }
 
-bool GenPCE::inTrail(Solver* s, Lit p, bool lock) {
-  for (int i = 0; i < s->getTrail().size(); i++) {
-    Var v = var(s->getTrail()[i]);
-    if (v == Minisat::var(p)){
-      if(lock) s->lock_reason(v);
-      return true;
+// Shrinks the conflict clause 'assumptions' (the negation of the failed
+// assumptions of the last call to 's') to a minimal unsatisfiable core.
+//
+// The core is built one transition literal at a time: a binary search finds
+// the shortest prefix of the candidates that is unsatisfiable together with
+// the literals already in the core, and the last literal of that prefix joins
+// the core (divide-and-conquer, as in QuickXplain). Every unsatisfiable call
+// drops the candidates that are not in its conflict (clause-set refinement),
+// and every model moves the candidates it satisfies into the satisfiable
+// prefix (model rotation for unit assumptions). A call that runs out of its
+// 'mus_budget' conflicts is treated as satisfiable, so the result is always a
+// core but may not be minimal.
+bool GenPCE::minimizeCore(Solver* s, MinVec& assumptions) {
+  MinVec core, candidates, current;
+  for (int i = 0; i < assumptions.size(); i++)
+    candidates.push(~assumptions[i]);
+  int initial = candidates.size();
+
+  while (candidates.size() > 0) {
+    int lo = core.size() > 0 ? -1 : 0; // Longest prefix known to be satisfiable (-1: none)
+    int hi = candidates.size();        // Shortest prefix known to be unsatisfiable
+
+    while (hi - lo > 1) {
+      int mid = (lo + hi) / 2;
+      core.copyTo(current);
+      for (int i = 0; i < mid; i++)
+        current.push(candidates[i]);
+
+      n_core_calls++;
+      if (mus_budget > 0)
+        s->setConfBudget(mus_budget);
+      lbool res = s->solveLimited(current);
+      s->budgetOff();
+
+      if (res == l_False) {
+        // Keep the candidates of the prefix that are in the conflict
+        int kept = 0, kept_lo = 0;
+        for (int i = 0; i < mid; i++) {
+          bool used = false;
+          for (int j = 0; j < s->conflict.size() && !used; j++)
+            used = s->conflict[j] == ~candidates[i];
+          if (!used) continue;
+          if (i < lo) kept_lo++;
+          candidates[kept++] = candidates[i];
+        }
+        candidates.shrink(candidates.size() - kept);
+        hi = kept;
+        if (lo > 0) lo = kept_lo;
+      } else if (res == l_True) {
+        cacheModel(s);
+        // The candidates satisfied by the model extend the satisfiable prefix
+        int k = mid;
+        for (int i = mid; i < hi; i++) {
+          if (s->modelValue(candidates[i]) == l_True) {
+            Lit tmp = candidates[k];
+            candidates[k++] = candidates[i];
+            candidates[i] = tmp;
+          }
+        }
+        lo = k < hi ? k : hi - 1;
+      } else
+        lo = mid;
     }
+
+    // The core alone is unsatisfiable
+    if (hi == 0)
+      break;
+    core.push(candidates[hi - 1]);
+    candidates.shrink(candidates.size() - (hi - 1));
   }
-  return false;
-}
 
-bool GenPCE::minimizeCore(Solver* s, MinVec& assumptions) {
-  
-  MinVec core;
-  for (int i = 0; i < assumptions.size(); i++)
-    core.push(~assumptions[i]);
   assumptions.clear();
+  for (int i = 0; i < core.size(); i++)
+    assumptions.push(~core[i]);
 
-  std::vector<bool> removed(core.size(), false);
-  for (int i = 0; i < core.size(); i++) {
-    MinVec current;
-    for (int j = 0; j < core.size(); j++){
-      if (removed[j] || i == j)
-        continue;
+  return (initial > assumptions.size());
+}
+
+
+// A clause is redundant if unit propagation on the other clauses, without
+// the clauses already found redundant, derives each of its literals from the
+// negation of the others. Only the clause under test is taken out of the
+// watch lists, so each check costs one propagation per literal, and the
+// checks of a clause share their assumption prefixes (see Solver::up).
+// A redundant clause is left out of the watch lists.
+bool GenPCE::redundantClause(Solver *min, int i, bool lock) {
+  // Without the clause the root-level assignment could shrink
+  if (min->is_locked(i) || min->isRootReason(i))
+    return false;
+
+  MinVec clause, assumptions;
+  min->getClause(i, clause);
+  min->disableClause(i);
+
+  // Locking marks the reasons of every literal, even of a kept clause
+  int implications = 0;
+  for (int j = 0; j < clause.size() && (lock || implications == j); j++) {
+    Minisat::Lit p = clause[j];
+    assumptions.clear();
+    for (int z = 0; z < clause.size(); z++)
+      if (j != z)
+        assumptions.push(~clause[z]);
+    min->up(assumptions);
+    if (min->implied(Minisat::var(p), lock)) implications++;
+  }
+
+  bool redundant = implications == clause.size();
+  if (!redundant) {
+    min->enableClause(i);
+    if (lock)
+      min->undo_locked();
+  }
+  if (lock)
+    min->clear_locked();
+  return redundant;
+}
 
-      current.push(core[j]);
+// Tests the clauses of 'begin', 'begin' + threads, ... below 'end' on 'copy'
+void GenPCE::minimizeWorker(Solver *copy, int begin, int end, std::vector<char> &candidate) {
+  for (int i = begin; i < end; i += threads) {
+    if (redundantClause(copy, i, false)) {
+      candidate[i] = true;
+      copy->enableClause(i);
     }
+  }
+}
 
-    bool res = s->solve(current);
-    if (!res) {
-      removed[i] = true;
+// The clauses are tested in batches by 'threads' copies of 'min', each copy
+// without the clauses found redundant in earlier batches. A clause that is
+// not redundant in a copy is not redundant with fewer clauses either, so only
+// the candidates are tested again on 'min', in order. The result is the
+// same as the one of the sequential test.
+// 'kept' counts the clauses kept so far; with 'cutoff' the test stops after
+// the first batch that makes the encoding unable to beat the incumbent.
+int GenPCE::minimizeParallel(Solver *s, Solver *min, std::vector<bool> &redundant,
+                             int kept, bool cutoff) {
+  std::vector<Solver*> copies;
+  MinVec none;
+  for (int t = 0; t < threads; t++) {
+    copies.push_back(new Solver());
+    s->cloneSolver(*copies[t]);
+    copies[t]->up(none);
+  }
+
+  int n_clauses = min->nClauses();
+  int batch = 64 * threads;
+  std::vector<char> candidate(n_clauses, false);
+  for (int start = 0; start < n_clauses && !(cutoff && pruned(kept)); start += batch) {
+    int end = std::min(start + batch, n_clauses);
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; t++)
+      pool.push_back(std::thread(&GenPCE::minimizeWorker, this, copies[t],
+                                 start + t, end, std::ref(candidate)));
+    for (int t = 0; t < threads; t++)
+      pool[t].join();
+
+    for (int i = start; i < end; i++) {
+      if (candidate[i] && redundantClause(min, i, false)) {
+        redundant[i] = true;
+        for (int t = 0; t < threads; t++)
+          copies[t]->disableClause(i);
+      } else
+        kept++;
     }
   }
-  for (int i = 0; i < core.size(); i++)
-    if (!removed[i]) assumptions.push(~core[i]);
 
-  return (core.size() > assumptions.size());
+  for (int t = 0; t < threads; t++)
+    delete copies[t];
+  return kept;
 }
 
-
-int GenPCE::minimize(Minisat::Solver *s, bool print) {
+// Returns the size of the minimal encoding, and stores its clauses in
+// 'clauses' if it is not NULL
+int GenPCE::minimize(Minisat::Solver *s, bool print, std::vector<StdVec> *clauses) {
   Solver min;
-  int o_vars = s->copySolver(min);
-  min.setAssumptions(o_vars);
+  s->cloneSolver(min);
+  int o_vars = min.nVars();
 
-  std::vector<bool> redundant(s->nClauses(), false);
-  int n_redundant = 0;
-  
-  for (int i = 0; i < min.nClauses(); i++) {
-    if (min.is_locked(i))
-      continue;
+  MinVec none;
+  min.up(none);
 
-    Minisat::vec<Minisat::Lit> clause;
-    min.getClause(i, clause);
-    Minisat::Lit disable = Minisat::lit_Undef;
-    int implications = 0;
-    for (int j = 0; j < clause.size(); j++) {
-      Minisat::vec<Minisat::Lit> assumptions;
-      Minisat::Lit p = clause[j];
-      if (Minisat::var(p) >= o_vars) continue;
-      for (int z = 0; z < clause.size(); z++) {
-        if (j == z) continue;
-        if (Minisat::var(clause[z]) >= o_vars) {
-          disable = clause[z];
-          assumptions.push(clause[z]);
-        } else {
-          assumptions.push(~clause[z]);
-        }
-      }
-      assert (disable != Minisat::lit_Undef);
-      // Disable the remaining assumptions
-      for (int w = 0; w < min.nClauses(); w++){
-        Minisat::Lit x = Minisat::mkLit(w+o_vars,true);
-        if (Minisat::var(disable) != Minisat::var(x)){
-          if (!redundant[w])
-            assumptions.push(x);  
-          else
-            assumptions.push(~x);  
-        }
-      }
-      min.up(assumptions);
-      if(inTrail(&min, p, locking)) implications++;
+  std::vector<bool> redundant(min.nClauses(), false);
+  
+  // A clause that is kept is never removed later, so the kept clauses are a
+  // lower bound of the cost while the test is running
+  int kept = min.nUnits();
+  bool cutoff = !print && incumbent != NULL;
+
+  // Locking depends on the reasons found by the earlier tests
+  if (threads > 1 && !locking)
+    kept = minimizeParallel(s, &min, redundant, kept, cutoff);
+  else {
+    for (int i = 0; i < min.nClauses() && !(cutoff && pruned(kept)); i++) {
+      redundant[i] = redundantClause(&min, i, locking);
+      if (!redundant[i])
+        kept++;
     }
-    if (implications == clause.size()-1) {
-      n_redundant++;
-      redundant[i] = true;
-    } else {
-      if (locking)
-        min.undo_locked();
+  }
+  if (cutoff && pruned(kept)) {
+    n_pruned++;
+    return kept;
+  }
+  int n_redundant = std::count(redundant.begin(), redundant.end(), true);
+
+  if (clauses != NULL) {
+    MinVec units;
+    MinVec clause;
+    min.getUnits(units);
+    for (int i = 0; i < units.size(); i++)
+      clauses->push_back(StdVec(1, units[i]));
+    for (unsigned i = 0; i < redundant.size(); i++) {
+      if (redundant[i] && !min.is_locked(i))
+        continue;
+      clause.clear();
+      min.getClause(i, clause);
+      clauses->push_back(StdVec());
+      for (int j = 0; j < clause.size(); j++)
+        clauses->back().push_back(clause[j]);
     }
-    if (locking)
-      min.clear_locked();
   }
 
   /*
@@ -213,63 +370,114 @@ int GenPCE::minimize(Minisat::Solver *s, bool print) {
 
 void GenPCE::greedyOptimization() {
 
+  if (beam_width > 0) {
+    beamSearch();
+    return;
+  }
+
   printStats("reference encoding", reference);
 
-  std::vector<bool> aux_vars(reference->nVars(), true);
-  for (int i = 0; i < inputs.size(); ++i) {
-    aux_vars[Minisat::var(inputs[i])] = false;
-  }
+  // A resumed run restores this state from the checkpoint
+  if (!resumed) {
+    aux_vars.assign(reference->nVars(), true);
+    for (int i = 0; i < inputs.size(); ++i) {
+      aux_vars[Minisat::var(inputs[i])] = false;
+    }
 
-  MinVec aux_inputs;
-  MinVec copy_inputs;
-  inputs.copyTo(copy_inputs);
+    aux_inputs.clear();
+    inputs.copyTo(copy_inputs);
+    iteration = 1;
+    candidate = GREEDY_FIRST;
+  }
 
-  int iteration = 1;
-  buildOptimal(false);
-  int cost = minimize(optimal, false);
-  std::cout << "c Iteration: " << iteration << "\t MinCls: " << cost << std::endl;
+  if (candidate == GREEDY_FIRST) {
+    buildOptimal(false);
+    if (!stopRequested()) {
+      cost = minimize(optimal, false);
+      std::cout << "c Iteration: " << iteration << "\t MinCls: " << cost << std::endl;
+      begin_cost = cost;
+      pos = 0;
+      candidate = 0;
+      best_optimal = optimal;
+      inputs.copyTo(best_inputs);
+      fillPool(optimal);
+    }
+  }
   
-  while (true) {
+  while (candidate != GREEDY_LAST && !stopRequested()) {
 
-    int begin_cost = cost;
-    int pos = 0;
+    if (threads > 1)
+      greedyParallel();
 
-    for (int i = 0; i < reference->nVars(); ++i){
-      if (!aux_vars[i]) 
+    for (; candidate < reference->nVars() && !stopRequested(); ++candidate){
+      if (!aux_vars[candidate]) 
         continue;
       
-      db_assignments.clear();
-      inputs.clear();
-      copy_inputs.copyTo(inputs);
-      inputs.push(Minisat::mkLit(i,false));
-      Solver * tmp = new Solver();
-      for (int j = 0 ; j < optimal->nVars(); j++)
-        tmp->newVar();
-      optimal = tmp;
+      if (!resumed) {
+        inputs.clear();
+        copy_inputs.copyTo(inputs);
+        inputs.push(Minisat::mkLit(candidate,false));
+        db_assignments.init(inputs);
+        freshOptimal();
+      }
 
       buildOptimal(false);
+      if (stopRequested())
+        break;
+
+      greedy_best = rankOf(cost, -1);
+      incumbent = &greedy_best;
+      rank_var = candidate;
       int iter_cost = minimize(optimal, false);
+      incumbent = NULL;
       if (iter_cost < cost) {
+        if (best_optimal != optimal)
+          releaseSolver(best_optimal);
         cost = iter_cost;
-        pos = i;
+        pos = candidate;
+        best_optimal = optimal;
+        inputs.copyTo(best_inputs);
       }
-      //std::cout << "c Variable: " << i+1 << "\t Cost: " << iter_cost << std::endl;
+      //std::cout << "c Variable: " << candidate+1 << "\t Cost: " << iter_cost << std::endl;
     }
 
+    if (stopRequested())
+      break;
+
     std::cout << "c Iteration: " << ++iteration << "\t MinCls: " << cost << std::endl;
     if (begin_cost == cost)
-      break;
+      candidate = GREEDY_LAST;
     else {
       assert (aux_vars[pos]);
       aux_vars[pos] = false;
       copy_inputs.push(Minisat::mkLit(pos,false)); 
       aux_inputs.push(Minisat::mkLit(pos,false)); 
+      // The encoding of the chosen candidate is lost if it was evaluated
+      // before the run was resumed
+      bool known = best_optimal != NULL && best_inputs.size() == copy_inputs.size() &&
+        Minisat::var(best_inputs.last()) == pos;
+      fillPool(known ? best_optimal : NULL);
+      begin_cost = cost;
+      pos = 0;
+      candidate = 0;
     }
   }
 
-  Solver * tmp = new Solver();
-  for (int i = 0 ; i < optimal->nVars(); i++)
-    tmp->newVar();
+  // Print the best complete encoding found before the search was stopped
+  if (stopRequested()) {
+    if (best_optimal == NULL) {
+      printInterrupted();
+      minimize(optimal, true);
+      return;
+    }
+    std::cout << "c :: interrupted :: " << stop_reason << std::endl;
+    std::cout << "c i";
+    for (int i = 0 ; i < best_inputs.size(); i++)
+      std::cout << " " << Minisat::var(best_inputs[i])+1;
+    std::cout << " 0" << std::endl;
+    minimize(best_optimal, true);
+    return;
+  }
 
   std::cout << "c i";
   for (int i = 0 ; i < copy_inputs.size(); i++)
@@ -280,19 +488,286 @@ void GenPCE::greedyOptimization() {
   for (int i = 0 ; i < aux_inputs.size(); i++)
     std::cout << " " << Minisat::var(aux_inputs[i])+1;
   std::cout << std::endl;
+  std::cout << "c :: pruned candidates :: " << n_pruned << std::endl;
+  std::cout << "c :: reused cubes :: " << n_reused_cubes << std::endl;
   
   // print the final formula
-  optimal = tmp;
-  inputs.clear();
-  db_assignments.clear();
-  copy_inputs.copyTo(inputs);
-  buildOptimal(false);
+  if (!resumed) {
+    freshOptimal();
+    inputs.clear();
+    copy_inputs.copyTo(inputs);
+    db_assignments.init(inputs);
+    streamClauses(greedy_pool);
+  }
+  buildOptimal(false, true);
+
+  // The best candidate already has a complete encoding for these inputs
+  if (stopRequested() && best_optimal != NULL) {
+    std::cout << "c :: interrupted :: " << stop_reason << std::endl;
+    minimize(best_optimal, true);
+    return;
+  }
+  if (stopRequested())
+    printInterrupted();
   minimize(optimal, true);
  
 }
 
+// Evaluates the remaining candidates of the iteration on 'threads' threads.
+// Each candidate is built and minimized by its own GenPCE on a fresh copy of
+// the reference, so its cost does not depend on the thread that evaluates it
+// or on the order of the evaluations. The best candidate is the one with the
+// lowest cost and, among those, the lowest variable.
+void GenPCE::greedyParallel() {
+  // A restored frontier belongs to a sequential run and is rebuilt
+  resumed = false;
+
+  greedy_candidates.clear();
+  for (Var v = candidate; v < reference->nVars(); v++)
+    if (aux_vars[v])
+      greedy_candidates.push_back(v);
+  greedy_costs.assign(greedy_candidates.size(), -1);
+  greedy_encodings.assign(greedy_candidates.size(), NULL);
+  greedy_next = 0;
+  greedy_cost = cost;
+  greedy_pos = pos;
+  greedy_best = rankOf(cost, -1);
+
+  std::vector<std::thread> pool;
+  for (int t = 0; t < threads; t++)
+    pool.push_back(std::thread(&GenPCE::greedyWorker, this));
+  for (unsigned t = 0; t < pool.size(); t++)
+    pool[t].join();
+
+  // Candidates that were not evaluated before a stop are skipped
+  int best = -1;
+  for (unsigned i = 0; i < greedy_candidates.size(); i++) {
+    if (greedy_costs[i] >= 0 && greedy_costs[i] < cost) {
+      cost = greedy_costs[i];
+      pos = greedy_candidates[i];
+      best = i;
+    }
+  }
+  if (best >= 0) {
+    if (best_optimal != optimal)
+      releaseSolver(best_optimal);
+    best_optimal = greedy_encodings[best];
+    copy_inputs.copyTo(best_inputs);
+    best_inputs.push(Minisat::mkLit(pos,false));
+  }
+  greedy_encodings.clear();
+
+  if (stop_reason == NULL)
+    candidate = reference->nVars();
+}
+
+void GenPCE::greedyWorker() {
+  for (;;) {
+    unsigned i;
+    {
+      std::lock_guard<std::mutex> guard(greedy_lock);
+      if (stop_reason != NULL || greedy_next >= greedy_candidates.size())
+        return;
+      i = greedy_next++;
+    }
+
+    Solver *encoding = NULL;
+    int c = evaluateCandidate(copy_inputs, greedy_pool, greedy_candidates[i],
+                              encoding, &greedy_best);
+
+    // Only the encoding of the best candidate so far is kept
+    std::lock_guard<std::mutex> guard(greedy_lock);
+    if (c < 0) {
+      releaseSolver(encoding);
+      return;
+    }
+    greedy_costs[i] = c;
+    if (c != INT_MAX && rankOf(c, greedy_candidates[i]) < greedy_best) {
+      greedy_best = rankOf(c, greedy_candidates[i]);
+      for (unsigned j = 0; j < greedy_encodings.size(); j++) {
+        releaseSolver(greedy_encodings[j]);
+        greedy_encodings[j] = NULL;
+      }
+      greedy_encodings[i] = encoding;
+    } else
+      releaseSolver(encoding);
+    if (checkpointDue())
+      greedyCheckpoint();
+  }
+}
+
+// Returns the cost of adding 'v' to the inputs 'base', whose minimal encoding
+// is 'pool', and its complete encoding in 'encoding'. Returns INT_MAX if it
+// can not beat 'bound' (NULL means no bound), or -1 if the search was stopped.
+// The minimal encoding is stored in 'clauses' if it is not NULL.
+int GenPCE::evaluateCandidate(const MinVec &base, const std::vector<StdVec> &pool,
+                              Var v, Solver *&encoding, std::atomic<long> *bound,
+                              std::vector<StdVec> *clauses) {
+  Solver copy;
+  {
+    std::lock_guard<std::mutex> guard(greedy_lock);
+    reference->cloneSolver(copy);
+    encoding = acquireSolver(optimal->nVars());
+  }
+
+  seedEncoding(encoding, pool);
+
+  MinVec candidate_inputs;
+  base.copyTo(candidate_inputs);
+  candidate_inputs.push(Minisat::mkLit(v,false));
+
+  GenPCE w(&copy, encoding, candidate_inputs, minimal, mus, locking, random,
+           false, seed, false);
+  w.mus_budget = mus_budget;
+  w.table_inputs = table_inputs;
+  w.use_symmetry = use_symmetry;
+  w.time_limit = time_limit;
+  w.mem_limit = mem_limit;
+  w.start_time = start_time;
+  w.incumbent = bound;
+  w.rank_var = v;
+  if (!pool.empty())
+    w.markComplete(base);
+
+  w.buildOptimal(false);
+  n_assignments += w.n_assignments;
+  n_reused_cubes += w.n_reused_cubes;
+  if (w.stopRequested()) {
+    std::lock_guard<std::mutex> guard(greedy_lock);
+    if (stop_reason == NULL)
+      stop_reason = w.stop_reason;
+    return -1;
+  }
+  int c = w.minimize(encoding, false, clauses);
+  if (w.n_pruned == 0)
+    return c;
+  n_pruned++;
+  return INT_MAX;
+}
+
+// Writes a checkpoint that a sequential run resumes from the first candidate
+// that has not been evaluated yet (called with 'greedy_lock' held)
+void GenPCE::greedyCheckpoint() {
+  unsigned first = 0;
+  while (first < greedy_costs.size() && greedy_costs[first] >= 0)
+    first++;
+  if (first == greedy_costs.size())
+    return;
+
+  int saved_cost = cost, saved_pos = pos;
+  cost = greedy_cost;
+  pos = greedy_pos;
+  for (unsigned i = 0; i < first; i++) {
+    if (greedy_costs[i] < cost) {
+      cost = greedy_costs[i];
+      pos = greedy_candidates[i];
+    }
+  }
+  candidate = greedy_candidates[first];
+
+  inputs.clear();
+  copy_inputs.copyTo(inputs);
+  inputs.push(Minisat::mkLit(candidate,false));
+  db_assignments.init(inputs);
+  freshOptimal();
+  assignment_heap = std::priority_queue<assignment, std::vector<assignment>,
+                                        GreaterThanBySize>();
+  assignment_heap.push(assignment());
+
+  writeCheckpoint();
+  cost = saved_cost;
+  pos = saved_pos;
+}
+
+// Returns an empty solver with 'n_vars' variables
+Solver* GenPCE::acquireSolver(int n_vars) {
+  std::lock_guard<std::mutex> guard(pool_lock);
+  Solver *s;
+  if (spare_solvers.empty()) {
+    s = new Solver();
+    pool_solvers.insert(s);
+  } else {
+    s = spare_solvers.back();
+    spare_solvers.pop_back();
+  }
+  while (s->nVars() < n_vars)
+    s->newVar();
+  return s;
+}
+
+// Gives back a solver of 'acquireSolver' (any other solver is left untouched)
+void GenPCE::releaseSolver(Solver *s) {
+  std::lock_guard<std::mutex> guard(pool_lock);
+  if (pool_solvers.count(s) == 0)
+    return;
+  s->reset();
+  spare_solvers.push_back(s);
+}
+
+// Appends 'clauses' to the stream, for the final encodings that do not learn
+// all their clauses
+void GenPCE::streamClauses(const std::vector<StdVec> &clauses) {
+  MinVec clause;
+  for (unsigned i = 0; i < clauses.size(); i++) {
+    convert(clauses[i], clause);
+    stream.add(clause);
+  }
+  stream.flush();
+}
+
+// Replaces 'optimal' by a solver that only holds the clause pool
+void GenPCE::freshOptimal() {
+  int n_vars = optimal->nVars();
+  if (optimal != best_optimal)
+    releaseSolver(optimal);
+  optimal = acquireSolver(n_vars);
+  seedEncoding(optimal, greedy_pool);
+}
+
+// Fills the pool with the minimal encoding of 'base', a complete encoding of
+// 'copy_inputs' (NULL if it is not known). The clauses are implied by the
+// reference, and they stay complete over 'copy_inputs' when an auxiliary
+// variable joins the inputs, so the candidates neither learn them again nor
+// call the SAT solver for the cubes over 'copy_inputs'.
+void GenPCE::fillPool(Solver *base) {
+  greedy_pool.clear();
+  complete_inputs.clear();
+  if (base == NULL)
+    return;
+
+  markComplete(copy_inputs);
+  minimize(base, false, &greedy_pool);
+}
+
+void GenPCE::markComplete(const MinVec &base) {
+  complete_inputs.assign(reference->nVars(), false);
+  for (int i = 0; i < base.size(); i++)
+    complete_inputs[Minisat::var(base[i])] = true;
+}
+
+void GenPCE::seedEncoding(Solver *s_opt, const std::vector<StdVec> &pool) {
+  MinVec clause;
+  for (unsigned i = 0; i < pool.size(); i++) {
+    convert(pool[i], clause);
+    s_opt->addClause__(clause);
+  }
+}
+
+// Returns true if 'optimal' was complete over the literals of 'core' from the
+// start, so that 'core' is satisfiable whenever it does not conflict
+bool GenPCE::completeCube(const StdVec &core) {
+  if (complete_inputs.empty())
+    return false;
+  for (unsigned i = 0; i < core.size(); i++)
+    if (!complete_inputs[Minisat::var(core[i])])
+      return false;
+  return true;
+}
+
+// Checks the assignment 'assign' extended with 'p' and, if it is satisfiable,
+// queues it to be expanded unless 'explore' is false
 bool GenPCE::solve(Solver * s, Solver * s_opt, 
-                          const assignment &assign, Lit p) {
+                          const assignment &assign, Lit p, bool explore) {
   assignment next;
   next.core = assign.core;
   next.pa = assign.pa;
@@ -308,7 +783,7 @@ bool GenPCE::solve(Solver * s, Solver * s_opt,
     bool result = s_opt->solve(assumptions);
     assert (!result);
 
-    s_opt->addClause__(s_opt->conflict);
+    learnClause(s_opt, s_opt->conflict);
     return false;
   }
 
@@ -324,12 +799,41 @@ bool GenPCE::solve(Solver * s, Solver * s_opt,
     up_lits.push(s_opt->getTrail()[i]);
 
   printVec("c :: assumptions :: ", assumptions, print);
-  bool result = s->solve(assumptions);
+  if (completeCube(next.core)) {
+    n_reused_cubes++;
+    if (explore)
+      pushAssignment(next);
+    return true;
+  }
+  if (!table.empty()) {
+    if (table.satisfiable(next.core)) {
+      if (explore)
+        pushAssignment(next);
+      return true;
+    }
+    // The cube is shrunk to a prime implicate, so -mus is not needed
+    StdVec core = next.core;
+    table.shrink(core);
+    MinVec clause;
+    for (unsigned i = 0; i < core.size(); i++)
+      clause.push(~core[i]);
+    printVec("c :: Learned clause :: ", clause, print);
+    learnClause(s_opt, clause);
+    return false;
+  }
+
+  bool result = cachedModel(next.core);
+  if (!result) {
+    result = s->solve(assumptions);
+    if (result)
+      cacheModel(s);
+  }
   assert (assumptions.size() > 0);
   
 
   if (result) {
-    assignment_heap.push(next);
+    if (explore)
+      pushAssignment(next);
   } else {
     assert (s->conflict.size() > 0);
     if (mus) {
@@ -355,35 +859,340 @@ bool GenPCE::solve(Solver * s, Solver * s_opt,
     }
 #else
     printVec("c :: Learned clause :: ",s->conflict, print);
-    s_opt->addClause__(s->conflict);  
+    learnClause(s_opt, s->conflict);
 #endif
     return false;
   }
   return true;
 }
 
-void GenPCE::buildOptimal(bool print) {
-
+unsigned GenPCE::expandAssignment(Solver *s, Solver *s_opt,
+                                  const assignment &current,
+                                  const StdVec &order,
+                                  std::vector<bool> &seen) {
   unsigned n_assignments = 0;
-  std::vector<bool> seen(reference->nVars(), false);
   std::vector<int> clear;
 
+  // Cache duplicates
+  std::vector<uint64_t> cube(db_assignments.width());
+  uint64_t hash = db_assignments.encode(current.core, &cube[0]);
+
+  for (unsigned i = 0; i < current.pa.size(); i++) {
+    seen[Minisat::var(current.pa[i])] = true; 
+    clear.push_back(Minisat::var(current.pa[i]));
+  }
+
+  for (unsigned i = 0; i < order.size(); i++) {
+    Minisat::Lit p = order[i];
+    if (seen[Minisat::var(p)])
+      continue;
+
+    bool pos_status = true;
+    bool neg_status = true;
+
+    // Assignments with another value of a split variable belong to other jobs
+    bool explore = split_vars.empty() || !split_vars[Minisat::var(p)];
+
+    if (neg_status && (symmetry.size() > 0 ? insertSymmetric(current.core, p) :
+                       insertAssignment(&cube[0], hash, p))) {
+      pos_status = solve(s, s_opt, current, p, explore);
+      n_assignments++;
+    }
+
+    if (pos_status && (symmetry.size() > 0 ? insertSymmetric(current.core, ~p) :
+                       insertAssignment(&cube[0], hash, ~p))) {
+      neg_status = solve(s, s_opt, current, ~p, explore);
+      n_assignments++;
+    }
+  }
+
+  for (unsigned i = 0; i < clear.size(); i++)
+    seen[clear[i]]= false;
+
+  return n_assignments;
+}
+
+bool GenPCE::insertAssignment(const uint64_t *cube, uint64_t hash, Lit p) {
+  if (threads > 1) {
+    std::lock_guard<std::mutex> guard(db_lock);
+    return db_assignments.insert(cube, hash, p);
+  }
+  return db_assignments.insert(cube, hash, p);
+}
+
+// Inserts the canonical cube of the orbit of 'core' extended with 'p', so that
+// only one cube of each orbit is explored
+bool GenPCE::insertSymmetric(const StdVec &core, Lit p) {
+  StdVec child(core);
+  child.push_back(p);
+  symmetry.canonical(child);
+
+  Lit q = child.back();
+  child.pop_back();
+  std::vector<uint64_t> cube(db_assignments.width());
+  uint64_t hash = db_assignments.encode(child, &cube[0]);
+  return insertAssignment(&cube[0], hash, q);
+}
+
+// Returns true if a recent model of the reference satisfies 'cube'
+bool GenPCE::cachedModel(const StdVec &cube) {
+  bool hit;
+  if (threads > 1) {
+    std::lock_guard<std::mutex> guard(models_lock);
+    hit = models.satisfies(cube);
+  } else
+    hit = models.satisfies(cube);
+  if (hit)
+    n_cached_models++;
+  return hit;
+}
+
+void GenPCE::cacheModel(Solver *s) {
+  if (threads > 1) {
+    std::lock_guard<std::mutex> guard(models_lock);
+    models.add(s->model);
+  } else
+    models.add(s->model);
+}
+
+void GenPCE::pushAssignment(const assignment &a) {
+  if (threads > 1) {
+    std::lock_guard<std::mutex> guard(frontier_lock);
+    assignment_heap.push(a);
+    frontier_cv.notify_one();
+  } else
+    assignment_heap.push(a);
+}
+
+// Blocks until an assignment is available or every worker is idle with an
+// empty frontier (end of the search)
+bool GenPCE::popAssignment(assignment &a) {
+  std::unique_lock<std::mutex> guard(frontier_lock);
+
+  if (stopRequested()) {
+    frontier_cv.notify_all();
+    return false;
+  }
+
+  // Checkpoints are written once every worker has finished its assignment
+  if (!checkpoint_pending && checkpointDue())
+    checkpoint_pending = true;
+  while (checkpoint_pending && busy_workers > 0)
+    frontier_cv.wait(guard);
+  if (checkpoint_pending) {
+    writeCheckpoint();
+    checkpoint_pending = false;
+    frontier_cv.notify_all();
+  }
+  if (streaming)
+    stream.tick();
+
+  while (assignment_heap.empty() && busy_workers > 0)
+    frontier_cv.wait(guard);
+
+  if (assignment_heap.empty()) {
+    frontier_cv.notify_all();
+    return false;
+  }
+
+  a.core = assignment_heap.top().core;
+  a.pa = assignment_heap.top().pa;
+  assignment_heap.pop();
+  busy_workers++;
+  return true;
+}
+
+// Adds 'clause' to the optimal encoding. With symmetries, all its images are
+// added as well so that the encoding is closed under the symmetry group, which
+// makes exploring one cube per orbit enough.
+void GenPCE::learnClause(Solver *s_opt, MinVec &clause) {
+  if (symmetry.size() == 0) {
+    addLearned(s_opt, clause);
+    return;
+  }
+
+  std::vector<StdVec> images;
+  symmetry.orbit(clause, images);
+  MinVec image;
+  for (unsigned i = 0; i < images.size(); i++) {
+    convert(images[i], image);
+    addLearned(s_opt, image);
+  }
+}
+
+// The clauses strengthened by subsumption are shared and streamed as well,
+// since the clauses they replace propagate less
+void GenPCE::addLearned(Solver *s_opt, MinVec &clause) {
+  Minisat::vec<MinVec> strengthened;
+  publishClause(clause);
+  s_opt->addClause__(clause, &strengthened);
+  for (int i = 0; i < strengthened.size(); i++)
+    publishClause(strengthened[i]);
+}
+
+void GenPCE::publishClause(const MinVec &clause) {
+  if (threads > 1) {
+    StdVec shared;
+    for (int i = 0; i < clause.size(); i++)
+      shared.push_back(clause[i]);
+    std::lock_guard<std::mutex> guard(clauses_lock);
+    shared_clauses.push_back(shared);
+  }
+  if (streaming)
+    stream.add(clause);
+}
+
+// Brings the clauses learned by other workers into the private optimal solver
+void GenPCE::importClauses(worker *w) {
+  std::vector<StdVec> pending;
+  {
+    std::lock_guard<std::mutex> guard(clauses_lock);
+    for (unsigned i = w->imported; i < shared_clauses.size(); i++)
+      pending.push_back(shared_clauses[i]);
+    w->imported = shared_clauses.size();
+  }
+
+  MinVec clause;
+  for (unsigned i = 0; i < pending.size(); i++) {
+    convert(pending[i], clause);
+    w->optimal.addClause__(clause);
+  }
+}
+
+void GenPCE::buildWorker(worker *w, const StdVec &order) {
+  std::vector<bool> seen(w->reference.nVars(), false);
+  assignment current;
+
+  while (popAssignment(current)) {
+    importClauses(w);
+
+    if (propagate(&w->optimal, current.core)) {
+      extendAssignment(&w->optimal, current.pa);
+      n_assignments += expandAssignment(&w->reference, &w->optimal,
+                                        current, order, seen);
+    }
+
+    std::lock_guard<std::mutex> guard(frontier_lock);
+    busy_workers--;
+    if (busy_workers == 0)
+      frontier_cv.notify_all();
+  }
+}
+
+// Clauses learned by a worker are shared through 'shared_clauses'. Workers may
+// explore cubes that are already blocked by clauses they have not imported
+// yet, which only costs redundant SAT calls: every learned clause is implied
+// by the reference and the merged encoding contains all of them.
+void GenPCE::buildParallel(const StdVec &order) {
+  std::vector<worker*> workers;
+  std::vector<std::thread> pool;
+  shared_clauses.clear();
+  busy_workers = 0;
+
+  for (int i = 0; i < threads; i++) {
+    worker *w = new worker();
+    reference->cloneSolver(w->reference);
+    optimal->cloneSolver(w->optimal);
+    w->optimal.setSubsumption(true);
+    w->optimal.setPropagator(true);
+    workers.push_back(w);
+  }
+
+  for (int i = 0; i < threads; i++)
+    pool.push_back(std::thread(&GenPCE::buildWorker, this, workers[i], 
+                               std::cref(order)));
+
+  for (int i = 0; i < threads; i++)
+    pool[i].join();
+
+  for (int i = 0; i < threads; i++)
+    delete workers[i];
+
+  // The shared clauses were streamed by the workers, but merging them can
+  // strengthen clauses again
+  MinVec clause;
+  Minisat::vec<MinVec> strengthened;
+  for (unsigned i = 0; i < shared_clauses.size(); i++) {
+    convert(shared_clauses[i], clause);
+    optimal->addClause__(clause, &strengthened);
+  }
+  shared_clauses.clear();
+  for (int i = 0; streaming && i < strengthened.size(); i++)
+    stream.add(strengthened[i]);
+}
+
+void GenPCE::buildOptimal(bool print, bool streamed) {
+
+  if (!resumed)
+    n_assignments = 0;
+  std::vector<bool> seen(reference->nVars(), false);
+  streaming = print || streamed;
+  models.init(inputs);
+  optimal->setSubsumption(true);
+  optimal->setPropagator(true);
+
+  table.clear();
+  if (table_inputs > 0 && inputs.size() <= table_inputs) {
+    // A stopped build leaves the table empty and the search calls the solver
+    if (table.build(*reference, inputs, [this]() { return stopRequested(); }) && print)
+      std::cout << "c :: truth table rows :: " << table.size() << std::endl;
+  }
+
+  // Canonical cubes could leave the job or the subtree of a seed, so
+  // symmetries are not used in jobs and repairs
+  symmetry.clear();
+  if (use_symmetry && split_vars.empty() && seeds.empty()) {
+    symmetry.detect(*reference, inputs);
+    if (print)
+      std::cout << "c :: symmetry generators :: " << symmetry.size() << std::endl;
+  }
+
   // Random order
-  std::srand(seed);
   std::vector<Lit> random_inputs;
   for (int i = 0; i < inputs.size(); i++)
     random_inputs.push_back(inputs[i]);
   
-  if (random)
+  if (random) {
+    std::lock_guard<std::mutex> guard(random_lock);
+    std::srand(seed);
     std::random_shuffle(random_inputs.begin(), random_inputs.end(), randomGenerator);
+  }
 
   if (print)
     printVec("c :: inputs :: ", random_inputs, true);
 
-  assignment assign;
-  assignment_heap.push(assign);
+  if (!resumed) {
+    assignment assign;
+    if (!seeds.empty()) {
+      // A repair only explores the extensions of the witnesses
+      for (unsigned i = 0; i < seeds.size(); i++) {
+        assign.core.assign(seeds[i].begin(), seeds[i].end() - 1);
+        assign.pa = assign.core;
+        assignment_heap.push(assign);
+      }
+      if (print)
+        std::cout << "c :: seeds :: " << seeds.size() << std::endl;
+    } else if (job_cube.empty())
+      assignment_heap.push(assign);
+    else {
+      // The root of a job is its cube
+      assign.core.assign(job_cube.begin(), job_cube.end() - 1);
+      assign.pa = assign.core;
+      solve(reference, optimal, assign, job_cube.back());
+      n_assignments++;
+    }
+  }
+  resumed = false;
+
+  if (threads > 1)
+    buildParallel(random_inputs);
+
+  while (assignment_heap.size() > 0 && !stopRequested()) {
+    if (checkpointDue())
+      writeCheckpoint();
+    if (streaming)
+      stream.tick();
 
-  while (assignment_heap.size() > 0) {
     assignment current;
     current.core = assignment_heap.top().core;
     current.pa = assignment_heap.top().pa;
@@ -393,62 +1202,25 @@ void GenPCE::buildOptimal(bool print) {
     if (!res) continue;
 
     extendAssignment(optimal, current.pa);
-    
-    for (unsigned i = 0; i < current.pa.size(); i++) {
-      seen[Minisat::var(current.pa[i])] = true; 
-      clear.push_back(Minisat::var(current.pa[i]));
-    }
-
-    for (unsigned i = 0; i < random_inputs.size(); i++) {
-      Minisat::Lit p = random_inputs[i];
-      if (seen[Minisat::var(p)])
-        continue;
-
-      // TODO: fix this version since this is too costly.
-      // Cache duplicates
-      std::vector<int> p_pos;
-      std::vector<int> p_neg;
-
-      for (unsigned i = 0; i < current.core.size(); i++) {
-        p_pos.push_back(toInt(current.core[i]));
-        p_neg.push_back(toInt(current.core[i]));
-      }
-
-      p_pos.push_back(Minisat::var(p)+1);
-      p_neg.push_back(-(Minisat::var(p)+1));
-      std::sort(p_pos.begin(), p_pos.end());
-      std::sort(p_neg.begin(), p_neg.end());
-
-      bool pos_status = true;
-      bool neg_status = true;
-
-      if (db_assignments.find(p_pos) == db_assignments.end() && 
-          neg_status) {
-        db_assignments.insert(p_pos); 
-        pos_status = solve(reference, optimal, current, p);
-        n_assignments++;
-      }
-
-      if (db_assignments.find(p_neg) == db_assignments.end() && 
-          pos_status) {
-        db_assignments.insert(p_neg); 
-        neg_status = solve(reference, optimal, current, ~p);
-        n_assignments++;
-      }
-
-    }
-
-    for (unsigned i = 0; i < clear.size(); i++)
-      seen[clear[i]]= false;
-    clear.clear();
+    n_assignments += expandAssignment(reference, optimal, current,
+                                      random_inputs, seen);
   }
+  stream.flush();
+  streaming = false;
 
   if (print) {
+    if (stopRequested())
+      printInterrupted();
     std::cout << "c :: clause minimization :: " << n_minimize_core << std::endl;
+    if (mus)
+      std::cout << "c :: clause minimization calls :: " << n_core_calls << std::endl;
     std::cout << "c :: assignments analyzed :: " << n_assignments << std::endl;  
+    std::cout << "c :: cached models :: " << n_cached_models << std::endl;
+    std::cout << "c :: subsumed clauses :: " << optimal->nSubsumed() << std::endl;
     printStats("reference encoding", reference);
   
-    if (minimal || locking) minimize(optimal, true);
+    if (exact) minimumEncoding(optimal, true);
+    else if (minimal || locking) minimize(optimal, true);
     else {
       //printf("c :: optimal encoding :: %d\n",optimal->nClauses()+optimal->nUnits());    
       printStats("optimal encoding", optimal);
@@ -457,114 +1229,222 @@ void GenPCE::buildOptimal(bool print) {
   }
 }
 
+// Checks that unit propagation on the reference derives every literal over
+// the inputs that it implies, for every partial assignment of the inputs. The
+// assignments are explored depth-first by 'threads' threads, each with its own
+// copy of the reference and its own stack. An idle thread steals the oldest
+// assignment of another stack. Each assignment that implies a literal without
+// propagating it is a witness, and once 'witness_limit' witnesses are found
+// all threads are interrupted. The witnesses are printed as
+//
+//   c witness <literals of the cube> 0 <implied literal> 0
+//
+// and can be given to a strengthen run with -seeds (see Witness.cc).
 bool GenPCE::checkOptimal(bool naive) {
 
-  unsigned n_assignments = 0;
+  n_assignments = 0;
   db_assignments.clear();
-  std::vector<StdVec> assignments;
-  StdVec empty;
-  assignments.push_back(empty);
+  db_conflicts.init(inputs);
+  check_stop = false;
+  check_pending = 0;
+  witnesses.clear();
 
   // Random order
   std::srand(seed);
   std::vector<Lit> random_inputs;
   for (int i = 0; i < inputs.size(); i++)
     random_inputs.push_back(inputs[i]);
-  std::vector<bool> seen(inputs.size(), false);
-  std::vector<int> clear;
 
   if (random)
     std::random_shuffle(random_inputs.begin(), random_inputs.end(), randomGenerator);
 
   printVec("c :: inputs :: ", random_inputs, print);
-  
-  while (assignments.size() > 0) {
 
-    StdVec current = assignments.back();
-    assignments.pop_back();
+  std::vector<checker*> checkers;
+  for (int i = 0; i < threads; i++) {
+    checker *c = new checker();
+    if (threads > 1) {
+      reference->cloneSolver(c->reference);
+      c->solver = &c->reference;
+    } else
+      c->solver = reference;
+    c->seen.assign(c->solver->nVars(), false);
+    checkers.push_back(c);
+  }
+  pushCheck(checkers[0], StdVec());
+
+  if (threads > 1) {
+    std::vector<std::thread> pool;
+    for (int i = 0; i < threads; i++)
+      pool.push_back(std::thread(&GenPCE::checkWorker, this, checkers[i],
+                                 std::cref(checkers), std::cref(random_inputs), naive));
+    for (int i = 0; i < threads; i++)
+      pool[i].join();
+  } else
+    checkWorker(checkers[0], checkers, random_inputs, naive);
+
+  reference->clearInterrupt();
+  for (int i = 0; i < threads; i++)
+    delete checkers[i];
 
-    bool res = propagate(reference, current);
-    if (!res) continue;
-    
-    StdVec implied = current;
-    extendAssignment(reference, implied);
+  std::cout << "c :: assignments analyzed :: " << n_assignments << std::endl;  
+  if (witnesses.empty())
+    return true;
 
-    for (unsigned i = 0; i < implied.size(); i++) {
-      seen[Minisat::var(implied[i])] = true; 
-      clear.push_back(Minisat::var(implied[i]));
-    }
+  std::cout << "c :: witnesses :: " << witnesses.size() << std::endl;
+  for (unsigned i = 0; i < witnesses.size(); i++)
+    printWitness(witnesses[i]);
+  return false;
+}
 
-    for (unsigned i = 0; i < random_inputs.size(); i++) {
-      Minisat::Lit p = random_inputs[i];
-      if (seen[Minisat::var(p)])
-      	continue;
+void GenPCE::checkWorker(checker *c, const std::vector<checker*> &checkers,
+                         const StdVec &order, bool naive) {
+  StdVec current;
+  while (popCheck(c, checkers, current)) {
+    if (!checkCube(c, current, order, naive) && !check_stop.exchange(true)) {
+      for (unsigned i = 0; i < checkers.size(); i++)
+        checkers[i]->solver->interrupt();
+    }
 
-      bool res_pos = true;
-      bool res_neg = true;
+    if (--check_pending == 0 || check_stop) {
+      std::lock_guard<std::mutex> guard(check_idle_lock);
+      check_idle_cv.notify_all();
+    }
+  }
+}
 
-      if (!naive) {
-        // TODO: fix the previous version since this is too costly.
-        // Cache duplicates
-        std::vector<int> p_pos;
-        std::vector<int> p_neg;
+// Records a witness for each input literal implied by 'current' but not
+// propagated, and returns false if the check must stop. The satisfiable
+// extensions of 'current' are pushed on the stack unless 'current' is a
+// witness, since repairing a witness covers all its extensions.
+bool GenPCE::checkCube(checker *c, const StdVec &current, const StdVec &order, bool naive) {
+  Solver *s = c->solver;
+  if (!propagate(s, current))
+    return true;
+
+  StdVec implied = current;
+  extendAssignment(s, implied);
+  for (unsigned i = 0; i < implied.size(); i++)
+    c->seen[Minisat::var(implied[i])] = true;
+
+  // Cache duplicates
+  std::vector<uint64_t> cube(db_assignments.width());
+  uint64_t hash = db_assignments.encode(current, &cube[0]);
+
+  bool complete = true;
+  bool stop = false;
+  std::vector<StdVec> children;
+  for (unsigned i = 0; i < order.size() && !stop && !check_stop; i++) {
+    Minisat::Lit p = order[i];
+    if (c->seen[Minisat::var(p)])
+      continue;
 
-        for (unsigned i = 0; i < current.size(); i++) {
-          p_pos.push_back(toInt(current[i]));
-          p_neg.push_back(toInt(current[i]));
+    for (int k = 0; k < 2 && !stop; k++) {
+      Minisat::Lit q = k == 0 ? p : ~p;
+      if (!naive && !insertAssignment(&cube[0], hash, q)) {
+        // The same cube was checked as the extension of another cube. If it
+        // was unsatisfiable, 'current' is a witness too (with several threads
+        // the other check may still be running, and the witness is missed)
+        if (checkConflict(&cube[0], hash, q, false)) {
+          complete = false;
+          stop = addWitness(current, ~q);
         }
+        continue;
+      }
 
-        p_pos.push_back(Minisat::var(p)+1);
-        p_neg.push_back(-(Minisat::var(p)+1));
-        std::sort(p_pos.begin(), p_pos.end());
-        std::sort(p_neg.begin(), p_neg.end());
-
-        if (db_assignments.find(p_pos) == db_assignments.end()) {
-          db_assignments.insert(p_pos); 
-          MinVec pos; convert(current, pos); pos.push(p);
-          printVec("c :: assumptions :: ", pos, print);
-          res_pos = reference->solve(pos);
-          n_assignments++;
-        }
+      MinVec assumptions;
+      convert(current, assumptions);
+      assumptions.push(q);
+      printVec("c :: assumptions :: ", assumptions, print);
+      lbool res = s->solveLimited(assumptions);
+      n_assignments++;
+
+      if (res == l_False) {
+        if (!naive)
+          checkConflict(&cube[0], hash, q, true);
+        complete = false;
+        stop = addWitness(current, ~q);
+      } else if (res == l_True) {
+        children.push_back(current);
+        children.back().push_back(q);
+      }
+    }
+  }
 
-        if (db_assignments.find(p_neg) == db_assignments.end()) {
-          db_assignments.insert(p_neg); 
-          MinVec neg; convert(current, neg); neg.push(~p);
-          printVec("c :: assumptions :: ", neg, print);
-          res_pos = reference->solve(neg);
-          n_assignments++;
-        }
-      } else {
-        MinVec pos; convert(current, pos); pos.push(p);
-	MinVec neg; convert(current, neg); neg.push(~p);
-      
-	printVec("c :: assumptions :: ", pos, print);
-	res_pos = reference->solve(pos);
-	printVec("c :: assumptions :: ", neg, print);
-	res_neg = reference->solve(neg);
-	n_assignments += 2;
+  for (unsigned i = 0; i < implied.size(); i++)
+    c->seen[Minisat::var(implied[i])] = false;
+
+  if (complete)
+    for (unsigned i = 0; i < children.size(); i++)
+      pushCheck(c, children[i]);
 
-      }    
+  return !stop;
+}
 
-      if (!res_pos || !res_neg)
-      	return false;
+// Looks up (or records if 'insert') that 'cube' extended with 'p' is unsatisfiable
+bool GenPCE::checkConflict(const uint64_t *cube, uint64_t hash, Lit p, bool insert) {
+  std::unique_lock<std::mutex> guard(db_lock, std::defer_lock);
+  if (threads > 1)
+    guard.lock();
+  return insert ? db_conflicts.insert(cube, hash, p) : db_conflicts.contains(cube, hash, p);
+}
 
-      if (res_pos) {
-        StdVec rpos = current; rpos.push_back(p);
-        assignments.push_back(rpos);
-      }
+// Returns true once 'witness_limit' witnesses are recorded
+bool GenPCE::addWitness(const StdVec &cube, Lit p) {
+  std::lock_guard<std::mutex> guard(witness_lock);
+  if (witness_limit > 0 && witnesses.size() >= (unsigned)witness_limit)
+    return true;
+  witnesses.push_back(cube);
+  witnesses.back().push_back(p);
+  return witness_limit > 0 && witnesses.size() >= (unsigned)witness_limit;
+}
+
+void GenPCE::printWitness(const StdVec &witness) {
+  std::cout << "c witness ";
+  for (unsigned i = 0; i + 1 < witness.size(); i++)
+    std::cout << toInt(witness[i]) << " ";
+  std::cout << "0 " << toInt(witness.back()) << " 0" << std::endl;
+}
+
+void GenPCE::pushCheck(checker *c, const StdVec &cube) {
+  {
+    std::lock_guard<std::mutex> guard(c->lock);
+    c->stack.push_back(cube);
+  }
+  check_pending++;
+  if (threads > 1)
+    check_idle_cv.notify_one();
+}
+
+// Pops the newest cube of the own stack or steals the oldest cube of another
+// stack. Returns false once every cube is checked or the check stopped.
+bool GenPCE::popCheck(checker *c, const std::vector<checker*> &checkers, StdVec &cube) {
+  {
+    std::lock_guard<std::mutex> guard(c->lock);
+    if (!c->stack.empty()) {
+      cube.swap(c->stack.back());
+      c->stack.pop_back();
+      return true;
+    }
+  }
 
-      if (res_neg) {
-        StdVec rneg = current; rneg.push_back(~p);
-        assignments.push_back(rneg);
+  unsigned self = std::find(checkers.begin(), checkers.end(), c) - checkers.begin();
+  while (!check_stop && check_pending > 0) {
+    for (unsigned i = 1; i < checkers.size(); i++) {
+      checker *other = checkers[(self + i) % checkers.size()];
+      std::lock_guard<std::mutex> guard(other->lock);
+      if (!other->stack.empty()) {
+        cube.swap(other->stack.front());
+        other->stack.pop_front();
+        return true;
       }
     }
 
-    for (unsigned i = 0; i < clear.size(); i++)
-      seen[clear[i]] = false;
-    clear.clear();
+    std::unique_lock<std::mutex> guard(check_idle_lock);
+    if (!check_stop && check_pending > 0)
+      check_idle_cv.wait_for(guard, std::chrono::milliseconds(1));
   }
-  std::cout << "c :: assignments analyzed :: " << n_assignments << std::endl;  
-  return true;
+  return false;
 }
 
 void GenPCE::printStats(const std::string type, Solver * s) {
@@ -28,6 +28,11 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define GenPCE_h
 
 #include "core/Solver.h"
+#include "CubeStore.h"
+#include "ClauseSink.h"
+#include "Symmetry.h"
+#include "ModelCache.h"
+#include "TruthTable.h"
 #include <algorithm>
 #include <set>
 #include <vector>
@@ -35,8 +40,17 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <iostream>
 #include <cmath>
 #include <queue>
+#include <deque>
+#include <chrono>
 #include <cstdlib>
+#include <climits>
 #include <map>
+#include <ctime>
+#include <csignal>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 
 typedef Minisat::Solver Solver;
 typedef Minisat::vec<Minisat::Lit> MinVec;
@@ -49,25 +63,106 @@ class GenPCE {
 	
   GenPCE(Solver *_reference, Solver *_optimal, MinVec& _inputs,
 		bool _minimal, bool _mus, bool _locking, bool _random, 
-    bool _greedy, int _seed, bool _print) {
+    bool _greedy, int _seed, bool _print, int _threads = 1) {
     reference = _reference;
     optimal = _optimal;
     _inputs.copyTo(inputs);
+    db_assignments.init(inputs);
     minimal = _minimal;
     mus = _mus;
     print = _print;
     locking = _locking;
     n_minimize_core = 0;
+    n_assignments = 0;
+    n_cached_models = 0;
+    n_core_calls = 0;
+    mus_budget = 0;
     random = _random;
     seed = _seed;
     greedy = _greedy;
+    threads = _threads;
+    busy_workers = 0;
+    resumed = false;
+    checkpoint_interval = 0;
+    checkpoint_pending = false;
+    last_checkpoint = time(NULL);
+    time_limit = 0;
+    mem_limit = 0;
+    start_time = time(NULL);
+    last_mem_check = start_time;
+    stop_reason = NULL;
+    best_optimal = NULL;
+    streaming = false;
+    use_symmetry = false;
+    witness_limit = 1;
+    table_inputs = 0;
+    exact = false;
+    incumbent = NULL;
+    rank_var = -1;
+    n_pruned = 0;
+    n_reused_cubes = 0;
+    beam_width = 0;
+    beam_depth = 0;
+  }
+  virtual ~GenPCE() {
+    for (std::set<Solver*>::iterator it = pool_solvers.begin(); it != pool_solvers.end(); ++it)
+      delete *it;
   }
-  virtual ~GenPCE(){};
 
   bool checkOptimal(bool naive = false); 
-  void buildOptimal(bool print = true);
+  void buildOptimal(bool print = true, bool streamed = false);
   void greedyOptimization();
 
+  // Writes the search state to 'file' every 'interval' seconds
+  void setCheckpoint(const char* file, int interval) {
+    checkpoint_file = file;
+    checkpoint_interval = interval;
+  }
+  // Restores the search state of a previous run (see Checkpoint.cc)
+  bool resume(const char* file);
+
+  // Appends every clause of the final encoding to 'file' as soon as it is learned
+  bool setStream(const char* file, bool append) { return stream.open(file, append); }
+
+  // Limits each SAT call made by -mus to 'conflicts' conflicts (0 means no limit)
+  void setMusBudget(int conflicts) { mus_budget = conflicts; }
+
+  // Prints a smallest optimal encoding made of the learned clauses (see Minimum.cc)
+  void setMinimum(bool enable) { exact = enable; }
+
+  // Replaces the SAT calls by a truth table when there are at most 'n' inputs (0 = never)
+  void setTableInputs(int n) { table_inputs = n; }
+
+  // Explores one cube per orbit of the input symmetries of the reference
+  void setSymmetry(bool enable) { use_symmetry = enable; }
+
+  // Cube-and-conquer (see Jobs.cc). A job only explores the assignments that
+  // agree with 'cube' on the 'split' variables.
+  void setJob(const MinVec& split, const MinVec& cube);
+  bool writeJobs(const char* prefix, int n_split);
+  bool mergeJobs(const char* prefix, int n_split);
+
+  // checkOptimal stops after 'limit' witnesses of incompleteness (0 means all)
+  void setWitnesses(int limit) { witness_limit = limit; }
+  // Repairs the optimal encoding from the witnesses of a previous check (see Witness.cc)
+  bool loadSeeds(const char* file);
+
+  // -greedy keeps the 'width' best sets of auxiliary variables of each level
+  // for at most 'depth' levels (see Beam.cc). Width 0 is the plain greedy
+  // search, and depth 0 stops after the first level that does not improve.
+  void setBeam(int width, int depth) {
+    beam_width = width;
+    beam_depth = depth;
+  }
+
+  // Stops the search after 'time' seconds or when 'mem' MB are used (0 means no limit)
+  void setLimits(int time, int mem) {
+    time_limit = time;
+    mem_limit = mem;
+  }
+  // Asks the search to stop and print the encoding found so far (signal safe)
+  static void interrupt() { stop_signal = 1; }
+
   static int randomGenerator(int i) { return std::rand()%i; }
 
  protected:
@@ -88,21 +183,116 @@ class GenPCE {
   std::priority_queue<assignment, std::vector<assignment>, GreaterThanBySize> 
     assignment_heap;
 
+  // Each worker owns private copies of the reference and optimal solvers
+  struct worker {
+    Solver reference;
+    Solver optimal;
+    unsigned imported;      // Number of 'shared_clauses' already in 'optimal'
+    worker() : imported(0) {}
+  };
+
+  // Each checkOptimal thread owns a DFS stack that the others steal from
+  struct checker {
+    Solver reference;
+    Solver *solver;         // 'reference' or, with one thread, the main reference
+    std::deque<StdVec> stack;
+    std::mutex lock;        // Protects 'stack'
+    std::vector<bool> seen;
+  };
+
+  void checkWorker(checker *c, const std::vector<checker*> &checkers,
+                   const StdVec &order, bool naive);
+  bool checkCube(checker *c, const StdVec &current, const StdVec &order, bool naive);
+  void pushCheck(checker *c, const StdVec &cube);
+  bool popCheck(checker *c, const std::vector<checker*> &checkers, StdVec &cube);
+  bool checkConflict(const uint64_t *cube, uint64_t hash, Lit p, bool insert);
+  bool addWitness(const StdVec &cube, Lit p);
+  void printWitness(const StdVec &witness);
+
+  unsigned expandAssignment(Solver *s, Solver *s_opt, const assignment &current,
+                            const StdVec &order, std::vector<bool> &seen);
+  void buildParallel(const StdVec &order);
+  void buildWorker(worker *w, const StdVec &order);
+  bool popAssignment(assignment &a);
+  void pushAssignment(const assignment &a);
+  bool insertAssignment(const uint64_t *cube, uint64_t hash, Lit p);
+  bool insertSymmetric(const StdVec &core, Lit p);
+  void learnClause(Solver *s_opt, MinVec &clause);
+  void addLearned(Solver *s_opt, MinVec &clause);
+  void publishClause(const MinVec &clause);
+  void importClauses(worker *w);
+  bool cachedModel(const StdVec &cube);
+  void cacheModel(Solver *s);
+
   void extendAssignment(Solver* solver, StdVec& pa);
   void convert(const StdVec& pa, MinVec& assumptions);
   bool propagate(Minisat::Solver* s, const StdVec& pa);
-  bool inTrail(Solver* s, Lit p, bool lock = true);
 
   void printVec(const std::string type, const MinVec &pa, bool print = false);
   void printVec(const std::string type, const StdVec &pa, bool print = false);
   void printVec(const std::string type, const std::vector<int> &pa, bool print = false);
 
-  bool solve(Solver * s, Solver * s_opt, const assignment &assign, Lit p);
-  int minimize(Solver *s, bool print = false);
+  bool solve(Solver * s, Solver * s_opt, const assignment &assign, Lit p,
+             bool explore = true);
+  int minimize(Solver *s, bool print = false, std::vector<StdVec> *clauses = NULL);
+  int minimizeParallel(Solver *s, Solver *min, std::vector<bool> &redundant,
+                       int kept, bool cutoff);
+  int minimumEncoding(Solver *s, bool print = false);
+  bool findWitness(Solver *full, Solver *sub, MinVec &cube, Lit &p);
+  bool redundantClause(Solver *min, int i, bool lock);
+  void minimizeWorker(Solver *copy, int begin, int end, std::vector<char> &candidate);
   bool minimizeCore(Solver* s, MinVec& assumptions);
 
+  void greedyParallel();
+  void greedyWorker();
+  int evaluateCandidate(const MinVec &base, const std::vector<StdVec> &pool,
+                        Var v, Solver *&encoding, std::atomic<long> *bound,
+                        std::vector<StdVec> *clauses = NULL);
+  void greedyCheckpoint();
+  void fillPool(Solver *base);
+  Solver* acquireSolver(int n_vars);
+  void releaseSolver(Solver *s);
+  void freshOptimal();
+  void markComplete(const MinVec &base);
+
+  // A set of auxiliary variables kept by the beam search
+  struct beam_state {
+    StdVec aux;                  // Sorted auxiliary variables
+    int cost;                    // -1 if the evaluation was stopped
+    std::vector<StdVec> pool;    // Minimal encoding of the inputs and 'aux'
+    bool operator<(const beam_state &b) const {
+      return cost != b.cost ? cost < b.cost : aux < b.aux;
+    }
+  };
+  // Extension of the beam state 'state' with the variable 'v'
+  struct beam_task {
+    int state;
+    Var v;
+    beam_state child;
+  };
+  void beamSearch();
+  void beamWorker(const std::vector<beam_state> *beam, std::vector<beam_task> *tasks);
+  void seedEncoding(Solver *s_opt, const std::vector<StdVec> &pool);
+  void streamClauses(const std::vector<StdVec> &clauses);
+  bool completeCube(const StdVec &core);
+
+  // Orders greedy candidates by cost and then by variable ('v' = -1 for the
+  // encoding the candidates must improve)
+  long rankOf(int c, Var v) { return (long)c * (reference->nVars() + 1) + v + 1; }
+  // A candidate with 'kept' irredundant clauses can not beat the incumbent
+  bool pruned(int kept) { return incumbent != NULL && rankOf(kept, rank_var) > *incumbent; }
+
   void printStats(const std::string type, Solver * s);
 
+  bool checkpointDue() {
+    return !checkpoint_file.empty() && 
+      time(NULL) - last_checkpoint >= checkpoint_interval;
+  }
+  void writeCheckpoint();
+
+  bool stopRequested();
+  void printInterrupted();
+
   int toInt(Lit p) { 
     int x = Minisat::var(p)+1; 
     if (Minisat::sign(p)) x = -x;
@@ -113,18 +303,126 @@ class GenPCE {
   Solver * optimal;
 
   bool minimal;
+  bool exact;             // -minimum
   bool mus;
   bool print;
   bool locking;
   bool random;
   int seed;
   bool greedy;
+  int threads;
 
   MinVec inputs;
   std::set<StdVec> db_clauses;
-  std::set<std::vector<int> > db_assignments;
+  CubeStore db_assignments;
+  CubeStore db_conflicts;        // Unsatisfiable cubes found by checkOptimal
+
+  std::atomic<unsigned> n_minimize_core;
+  std::atomic<unsigned> n_assignments;
+  std::atomic<unsigned> n_cached_models; // SAT calls answered by 'models'
+  std::atomic<unsigned> n_core_calls;    // SAT calls made by 'minimizeCore'
+  int mus_budget;                        // Conflicts per call of 'minimizeCore' (0 = no limit)
+
+  // State of greedyOptimization (saved in checkpoints)
+  enum { GREEDY_FIRST = -1, GREEDY_LAST = -2 };
+  std::vector<bool> aux_vars;
+  MinVec copy_inputs;
+  MinVec aux_inputs;
+  int iteration;
+  int cost;
+  int begin_cost;
+  int pos;
+  int candidate;          // Next auxiliary variable to evaluate
+
+  // Candidates of the current iteration evaluated by greedyParallel
+  std::vector<Var> greedy_candidates;
+  std::vector<int> greedy_costs;         // -1 until the candidate is evaluated
+  std::vector<Solver*> greedy_encodings;
+  unsigned greedy_next;                  // Next candidate handed to a thread
+  int greedy_cost;                       // Best cost and variable of the
+  int greedy_pos;                        // candidates before the first one
+  std::mutex greedy_lock;
+
+  // Branch and bound of the candidate evaluations: 'minimize' stops as soon as
+  // the clauses it keeps can not beat 'incumbent' (the rank of the best encoding)
+  std::atomic<long> greedy_best;
+  std::atomic<long> *incumbent;          // NULL when minimize is not bounded
+  Var rank_var;                          // Candidate evaluated by 'minimize'
+  std::atomic<unsigned> n_pruned;        // Candidates rejected by the bound
+
+  // Clauses of the complete encoding of 'copy_inputs' that every candidate of
+  // the iteration starts from (saved in checkpoints)
+  std::vector<StdVec> greedy_pool;
+  std::vector<bool> complete_inputs;     // 'optimal' is complete over these inputs
+  std::atomic<unsigned> n_reused_cubes;  // SAT calls answered by 'complete_inputs'
+
+  // Optimal solvers of the greedy candidates, reset and reused instead of
+  // being allocated for every candidate
+  std::set<Solver*> pool_solvers;        // Every solver made by 'acquireSolver'
+  std::vector<Solver*> spare_solvers;    // Reset solvers ready to be reused
+  std::mutex pool_lock;
+
+  // Beam search (see Beam.cc)
+  int beam_width;
+  int beam_depth;
+
+  // Checkpointing
+  std::string checkpoint_file;
+  int checkpoint_interval;
+  time_t last_checkpoint;
+  bool checkpoint_pending;
+  bool resumed;           // The state was restored and the search must continue
+
+  // Anytime search
+  static volatile sig_atomic_t stop_signal;
+  static std::mutex random_lock;         // std::srand and std::rand are shared by all threads
+  int time_limit;
+  int mem_limit;
+  time_t start_time;
+  time_t last_mem_check;
+  const char* stop_reason; // Why the search stopped (NULL if it was not stopped)
+  Solver * best_optimal;   // Complete encoding of the best greedy candidate
+  MinVec best_inputs;
+
+  // Streaming of the learned clauses (only the final encoding is streamed)
+  ClauseSink stream;
+  bool streaming;
+
+  // Input symmetries of the reference (detected by buildOptimal)
+  Symmetry symmetry;
+  bool use_symmetry;
+
+  // Rows of the reference over the inputs (used instead of SAT calls if not empty)
+  TruthTable table;
+  int table_inputs;             // Largest number of inputs for which 'table' is built
+
+  // Recent models of the reference over the inputs
+  ModelCache models;
+  std::mutex models_lock;
+
+  // Job of a split run (empty when the whole input space is explored)
+  std::vector<bool> split_vars;
+  StdVec job_cube;
+
+  // Shared state of checkOptimal
+  std::atomic<long> check_pending;  // Cubes on the stacks or being checked
+  std::atomic<bool> check_stop;     // Enough witnesses were found
+  std::mutex check_idle_lock;
+  std::condition_variable check_idle_cv;
+  std::vector<StdVec> witnesses;    // Cube followed by a literal it implies but does not propagate
+  std::mutex witness_lock;
+  int witness_limit;                // Witnesses collected before the check stops (0 = all)
+
+  // Witness cubes whose extensions are explored by buildOptimal
+  std::vector<StdVec> seeds;
 
-  unsigned n_minimize_core;
+  // Shared state of the parallel search (only used when threads > 1)
+  std::mutex frontier_lock;
+  std::condition_variable frontier_cv;
+  int busy_workers;
+  std::mutex db_lock;
+  std::mutex clauses_lock;
+  std::vector<StdVec> shared_clauses;
 
 };
 
@@ -0,0 +1,170 @@
+/******************************************************************************************[Jobs.cc]
+GenPCE -- Copyright (c) 2016, Ruben Martins, Martin Brain, Liana Hadarean, Daniel Kroening
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************/
+
+#include "GenPCE.h"
+#include "core/Dimacs.h"
+#include <zlib.h>
+#include <algorithm>
+#include <set>
+#include <string>
+#include <stdio.h>
+
+// Cube-and-conquer: a split run writes one job per cube over the first
+// 'n_split' inputs. Each split variable is positive, negative or unassigned in
+// a cube, so there are 3^n_split jobs and every partial assignment of the
+// inputs agrees with the cube of exactly one of them. A job file is the
+// reference encoding with two more comments:
+//
+//   c split <split variables> 0
+//   c cube <literals of the cube> 0
+//
+// The encoding built for a job is complete for the assignments of its job,
+// and since unit propagation is monotone the union of the encodings of all
+// jobs is complete for every assignment.
+
+static std::string jobFile(const char* prefix, int job, const char* ext) {
+  char suffix[32];
+  snprintf(suffix, sizeof(suffix), "-%d.%s", job, ext);
+  return std::string(prefix) + suffix;
+}
+
+static void writeLits(FILE* f, const MinVec& lits) {
+  for (int i = 0; i < lits.size(); i++)
+    fprintf(f, "%s%d ", Minisat::sign(lits[i]) ? "-" : "", Minisat::var(lits[i])+1);
+  fprintf(f, "0\n");
+}
+
+static int nJobs(int n_split) {
+  int n_jobs = 1;
+  for (int i = 0; i < n_split; i++)
+    n_jobs *= 3;
+  return n_jobs;
+}
+
+void GenPCE::setJob(const MinVec& split, const MinVec& cube) {
+  split_vars.assign(reference->nVars(), false);
+  for (int i = 0; i < split.size(); i++)
+    split_vars[Minisat::var(split[i])] = true;
+
+  job_cube.clear();
+  for (int i = 0; i < cube.size(); i++)
+    job_cube.push_back(cube[i]);
+}
+
+bool GenPCE::writeJobs(const char* prefix, int n_split) {
+  MinVec units, clause, split, cube;
+  reference->getUnits(units);
+  for (int i = 0; i < n_split; i++)
+    split.push(Minisat::mkLit(Minisat::var(inputs[i])));
+
+  int n_jobs = nJobs(n_split);
+  for (int job = 0; job < n_jobs; job++) {
+    cube.clear();
+    for (int i = 0, code = job; i < n_split; i++, code /= 3) {
+      if (code % 3 == 1) cube.push(split[i]);
+      if (code % 3 == 2) cube.push(~split[i]);
+    }
+
+    std::string file = jobFile(prefix, job, "cnf");
+    FILE* f = fopen(file.c_str(), "w");
+    if (f == NULL) {
+      std::cerr << "Could not open file : " << file << std::endl;
+      return false;
+    }
+
+    fprintf(f, "c i ");
+    writeLits(f, inputs);
+    fprintf(f, "c split ");
+    writeLits(f, split);
+    fprintf(f, "c cube ");
+    writeLits(f, cube);
+    fprintf(f, "p cnf %d %d\n", reference->nVars(), reference->nClauses() + units.size());
+    for (int i = 0; i < units.size(); i++)
+      fprintf(f, "%s%d 0\n", Minisat::sign(units[i]) ? "-" : "", Minisat::var(units[i])+1);
+    for (int i = 0; i < reference->nClauses(); i++) {
+      clause.clear();
+      reference->getClause(i, clause);
+      writeLits(f, clause);
+    }
+    fclose(f);
+  }
+
+  std::cout << "c :: jobs :: " << n_jobs << std::endl;
+  return true;
+}
+
+bool GenPCE::mergeJobs(const char* prefix, int n_split) {
+  std::set<StdVec> merged;
+  MinVec units, clause;
+
+  int n_jobs = nJobs(n_split);
+  for (int job = 0; job < n_jobs; job++) {
+    std::string file = jobFile(prefix, job, "out");
+    gzFile gz = gzopen(file.c_str(), "rb");
+    if (gz == NULL) {
+      std::cerr << "Could not open file : " << file << std::endl;
+      return false;
+    }
+    Solver part;
+    Minisat::parse_DIMACS(gz, part);
+    gzclose(gz);
+
+    units.clear();
+    part.getUnits(units);
+    for (int i = 0; i < units.size(); i++)
+      merged.insert(StdVec(1, units[i]));
+
+    for (int i = 0; i < part.nClauses(); i++) {
+      clause.clear();
+      part.getClause(i, clause);
+      StdVec sorted;
+      for (int j = 0; j < clause.size(); j++)
+        sorted.push_back(clause[j]);
+      std::sort(sorted.begin(), sorted.end());
+      merged.insert(sorted);
+    }
+  }
+
+  optimal->setSubsumption(true);
+  for (std::set<StdVec>::const_iterator it = merged.begin(); it != merged.end(); ++it) {
+    convert(*it, clause);
+    for (int i = 0; i < clause.size(); i++)
+      while (Minisat::var(clause[i]) >= optimal->nVars())
+        optimal->newVar();
+    optimal->addClause__(clause);
+  }
+
+  std::cout << "c :: merged jobs :: " << n_jobs << std::endl;
+  std::cout << "c :: subsumed clauses :: " << optimal->nSubsumed() << std::endl;
+  printStats("reference encoding", reference);
+  if (exact) minimumEncoding(optimal, true);
+  else if (minimal || locking) minimize(optimal, true);
+  else {
+    printStats("optimal encoding", optimal);
+    optimal->printFormula();
+  }
+  return true;
+}
@@ -27,6 +27,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <assert.h>
 #include <iostream>
 
+#include <signal.h>
 #include <zlib.h>
 
 #include "core/Dimacs.h"
@@ -88,6 +89,13 @@ void updateVariables (Solver& reference, MinVec& inputs) {
   reference.loadIO(inputs);
 }
 
+// The first signal stops the search and prints the encoding found so far, a
+// second one terminates immediately.
+static void SIGINT_interrupt(int signum) { 
+  GenPCE::interrupt();
+  signal(signum, SIG_DFL);
+}
+
 int main (int argc, char **argv) {
 
   Solver reference;
@@ -95,18 +103,51 @@ int main (int argc, char **argv) {
   MinVec inputs;
 
   BoolOption mus("GenPCE", "mus", "Minimizes the unsat core.\n",false);
+  Minisat::IntOption mus_budget("GenPCE", "mus-budget",
+				"Conflicts allowed in each SAT call of -mus (0 = no limit).\n",10000, Minisat::IntRange(0, INT32_MAX));
   BoolOption minimal_lock("GenPCE","minimal-lock",
 			  "Minimizes the encoding by locking reasons.\n",false);
   BoolOption minimal("GenPCE", "minimal", "Minimizes the encoding.\n",false);
+  BoolOption minimum("GenPCE", "minimum", "Finds a smallest optimal encoding made of the learned clauses.\n",false);
   BoolOption check("GenPCE", "optimal", 
                    "Checks if an encoding is optimal.\n",false);
   BoolOption check_naive("GenPCE", "optimal-naive", 
 			 "Checks if an encoding is optimal.\n",false);
+  Minisat::IntOption witnesses("GenPCE", "witnesses",
+				"Witnesses of incompleteness printed by -optimal (0 = all).\n",1, Minisat::IntRange(0, INT32_MAX));
+  Minisat::StringOption seeds("GenPCE", "seeds",
+			      "Repairs the strengthen encoding from the witnesses in this file.\n");
   BoolOption print("GenPCE", "print", "Prints debug information.\n",false);
   BoolOption random("GenPCE", "random", "Uses a random seed.\n",false);
   Minisat::IntOption seed("GenPCE", "seed",
 			  "Random seed number.\n",91648253, Minisat::IntRange(1, INT32_MAX));
+  Minisat::IntOption threads("GenPCE", "threads",
+			     "Number of worker threads.\n",1, Minisat::IntRange(1, INT32_MAX));
+  Minisat::StringOption checkpoint("GenPCE", "checkpoint",
+				   "Periodically saves the search state to this file.\n");
+  Minisat::IntOption checkpoint_interval("GenPCE", "checkpoint-interval",
+					 "Seconds between checkpoints.\n",600, Minisat::IntRange(1, INT32_MAX));
+  Minisat::StringOption resume("GenPCE", "resume",
+			       "Resumes the search from a checkpoint file.\n");
+  Minisat::StringOption stream("GenPCE", "stream",
+			       "Writes each learned clause to this file (or pipe) as soon as it is found.\n");
+  Minisat::IntOption time_limit("GenPCE", "time-limit",
+				"Stops the search after this many seconds (0 = no limit).\n",0, Minisat::IntRange(0, INT32_MAX));
+  Minisat::IntOption mem_limit("GenPCE", "mem-limit",
+			       "Stops the search when this many MB are used (0 = no limit).\n",0, Minisat::IntRange(0, INT32_MAX));
+  Minisat::IntOption table_inputs("GenPCE", "table-inputs",
+				  "Uses a truth table instead of SAT calls up to this many inputs (0 = never).\n",14, Minisat::IntRange(0, 30));
+  BoolOption symmetry("GenPCE", "symmetry", "Explores one assignment per orbit of the input symmetries.\n",false);
+  Minisat::IntOption split("GenPCE", "split",
+			   "Writes one job file per cube over this many inputs.\n",0, Minisat::IntRange(0, INT32_MAX));
+  Minisat::StringOption jobs("GenPCE", "jobs",
+			     "Prefix of the job files.\n","job");
+  BoolOption merge("GenPCE", "merge", "Merges the encodings built for the jobs.\n",false);
   BoolOption greedy("GenPCE", "greedy", "Minimises the encoding with a greedy auxiliarly variable manager.\n",false);
+  Minisat::IntOption beam_width("GenPCE", "beam-width",
+				"With -greedy, keeps this many sets of auxiliary variables per level (0 = greedy).\n",0, Minisat::IntRange(0, INT32_MAX));
+  Minisat::IntOption beam_depth("GenPCE", "beam-depth",
+				"Levels of the beam search (0 = until a level does not improve).\n",0, Minisat::IntRange(0, INT32_MAX));
 
   Minisat::parseOptions(argc, argv, true);
 
@@ -122,7 +163,67 @@ int main (int argc, char **argv) {
 
   GenPCE finder(&reference, &optimal, inputs, 
                        minimal, mus, minimal_lock, random, 
-                       greedy, (int)seed, print);
+                       greedy, (int)seed, print, (int)threads);
+  if (checkpoint)
+    finder.setCheckpoint(checkpoint, checkpoint_interval);
+  finder.setLimits(time_limit, mem_limit);
+  finder.setSymmetry(symmetry);
+  finder.setTableInputs(table_inputs);
+  finder.setMinimum(minimum);
+  finder.setMusBudget(mus_budget);
+  finder.setWitnesses(witnesses);
+  finder.setBeam(beam_width, beam_depth);
+  if (stream && !finder.setStream(stream, (const char*)resume != NULL)) {
+    std::cerr << "Could not open stream : " << (const char*)stream << std::endl;
+    return 1;
+  }
+  // A reader of a named pipe that goes away makes the writes fail instead
+  if (stream)
+    signal(SIGPIPE, SIG_IGN);
+  if (!check && !check_naive) {
+    signal(SIGINT, SIGINT_interrupt);
+    signal(SIGTERM, SIGINT_interrupt);
+  }
+  if (beam_width > 0 && (!greedy || checkpoint || resume)) {
+    std::cerr << "The beam search needs -greedy and can not be checkpointed" << std::endl;
+    return 1;
+  }
+  if (resume && !finder.resume(resume)) {
+    std::cerr << "Could not resume from checkpoint : " << (const char*)resume
+	      << std::endl;
+    return 1;
+  }
+
+  // A job file restricts the search to its cube
+  if (reference.getSplit().size() > 0) {
+    if (greedy) {
+      std::cerr << "A job can not be run with -greedy" << std::endl;
+      return 1;
+    }
+    finder.setJob(reference.getSplit(), reference.getCube());
+  }
+
+  if (seeds) {
+    if (greedy || reference.getSplit().size() > 0) {
+      std::cerr << "Seeds can not be used with -greedy or in a job" << std::endl;
+      return 1;
+    }
+    if (!finder.loadSeeds(seeds)) {
+      std::cerr << "Could not read seeds : " << (const char*)seeds << std::endl;
+      return 1;
+    }
+  }
+
+  if (merge)
+    return finder.mergeJobs(jobs, split) ? 10 : 1;
+  if (split > 0) {
+    if (split > inputs.size()) {
+      std::cerr << "Can not split on more than " << inputs.size() << " inputs" << std::endl;
+      return 1;
+    }
+    return finder.writeJobs(jobs, split) ? 0 : 1;
+  }
+
   if (check || check_naive) {
     if (finder.checkOptimal(check_naive)) {
       std::cout << "c :: OPTIMAL ENCODING" << std::endl;
@@ -0,0 +1,278 @@
+/***************************************************************************************[Minimum.cc]
+GenPCE -- Copyright (c) 2016, Ruben Martins, Martin Brain, Liana Hadarean, Daniel Kroening
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************/
+
+#include "GenPCE.h"
+
+using Minisat::lbool;
+
+// Exact minimization (-minimum): the smallest subset of the clauses of the
+// optimal encoding that is still propagation complete, found as a minimum
+// hitting set.
+//
+// Since the encoding F is propagation complete, a subset S is complete iff
+// unit propagation on S derives on every cube over the inputs what it
+// derives on F. A cube where it does not is a witness. S is grown with the
+// clauses of F that keep the witness (in clause order), and at least one
+// clause outside the grown set must be kept: this is a new set to hit.
+//
+// The hitting sets are computed by an incremental SAT solver with one
+// variable per clause, which is assumed false (the clause is dropped). Each
+// unsatisfiable core raises the lower bound by one and is relaxed by a
+// totalizer that allows one of its literals to be true, and the bound of
+// a totalizer in a later core is raised instead (OLL). Sets to hit only add
+// clauses, so the cores stay valid and the solver is reused for all of
+// them. A hitting set found is the smallest for the sets so far, so the
+// first one without a witness is a smallest complete subset.
+//
+// Clauses that are the reason of a root-level literal are always kept, as
+// the root-level assignment is shared by all subsets.
+
+// Builds a unary counter of 'in': out[i] is true if at least i+1 inputs are
+static void totalizer(Solver& s, const MinVec& in, MinVec& out) {
+  out.clear();
+  if (in.size() == 1) {
+    out.push(in[0]);
+    return;
+  }
+
+  MinVec left, right, left_out, right_out;
+  for (int i = 0; i < in.size(); i++)
+    (i < in.size() / 2 ? left : right).push(in[i]);
+  totalizer(s, left, left_out);
+  totalizer(s, right, right_out);
+
+  for (int i = 0; i < in.size(); i++)
+    out.push(Minisat::mkLit(s.newVar()));
+
+  MinVec clause;
+  for (int i = 0; i <= left_out.size(); i++)
+    for (int j = 0; j <= right_out.size(); j++) {
+      if (i + j == 0)
+        continue;
+      clause.clear();
+      if (i > 0) clause.push(~left_out[i-1]);
+      if (j > 0) clause.push(~right_out[j-1]);
+      clause.push(out[i+j-1]);
+      s.addClause(clause);
+    }
+}
+
+// Returns true if unit propagation under 'cube' on 'sub' derives 'p' (a
+// conflict if 'p' is undefined)
+static bool derives(Solver& sub, const MinVec& cube, Lit p) {
+  bool consistent = sub.up(cube);
+  if (p == Minisat::lit_Undef)
+    return !consistent;
+  return !consistent || sub.value(p) == l_True;
+}
+
+// Looks for a cube on which unit propagation on 'sub' misses a literal over
+// the inputs (or a conflict) that it derives on 'full'
+bool GenPCE::findWitness(Solver *full, Solver *sub, MinVec &cube, Lit &p) {
+  CubeStore visited;
+  visited.init(inputs);
+  std::vector<StdVec> stack(1);
+  std::vector<uint64_t> bits(visited.width());
+
+  while (!stack.empty() && !stopRequested()) {
+    StdVec current;
+    current.swap(stack.back());
+    stack.pop_back();
+    convert(current, cube);
+
+    if (!full->up(cube)) {
+      p = Minisat::lit_Undef;
+      if (sub->up(cube))
+        return true;
+      continue;
+    }
+    sub->up(cube);
+
+    std::vector<Var> free;
+    for (int i = 0; i < inputs.size(); i++) {
+      Var v = Minisat::var(inputs[i]);
+      if (full->value(v) != l_Undef && sub->value(v) == l_Undef) {
+        p = Minisat::mkLit(v, full->value(v) == l_False);
+        return true;
+      }
+      if (full->value(v) == l_Undef)
+        free.push_back(v);
+    }
+
+    uint64_t hash = visited.encode(current, &bits[0]);
+    for (unsigned i = free.size(); i-- > 0; ) {
+      for (int k = 0; k < 2; k++) {
+        Lit q = Minisat::mkLit(free[i], k == 1);
+        if (visited.insert(&bits[0], hash, q)) {
+          stack.push_back(current);
+          stack.back().push_back(q);
+        }
+      }
+    }
+  }
+  return false;
+}
+
+// Unary counter of an OLL relaxation: at most 'bound' of its inputs are true
+struct Relaxation {
+  StdVec out;
+  int bound;
+};
+
+int GenPCE::minimumEncoding(Solver *s, bool print) {
+  Solver full, sub, hs;
+  s->cloneSolver(full);
+  s->cloneSolver(sub);
+  int o_vars = full.nVars();
+  int n_clauses = full.nClauses();
+
+  MinVec none;
+  full.up(none);
+  sub.up(none);
+
+  // Soft literals: ~selectors[i] (clause i is dropped)
+  MinVec selectors;
+  std::vector<bool> relaxed(n_clauses, false);
+  for (int i = 0; i < n_clauses; i++) {
+    selectors.push(Minisat::mkLit(hs.newVar()));
+    if (full.isRootReason(i))
+      hs.addClause(selectors[i]);
+  }
+  std::vector<Relaxation> relaxations;
+  std::map<Lit, int> bounded;     // Output literal of a relaxation at its bound
+
+  std::vector<bool> kept(n_clauses, true);
+  MinVec cube, assumptions, clause, core;
+  Lit p = Minisat::lit_Undef;
+  int lower_bound = 0;
+  int iterations = 0;
+  bool found = false;
+
+  while (!found && !stopRequested()) {
+    assumptions.clear();
+    for (int i = 0; i < n_clauses; i++)
+      if (!relaxed[i])
+        assumptions.push(~selectors[i]);
+    for (unsigned i = 0; i < relaxations.size(); i++)
+      if (relaxations[i].bound < (int)relaxations[i].out.size())
+        assumptions.push(~relaxations[i].out[relaxations[i].bound]);
+
+    lbool res = l_Undef;
+    while (res == l_Undef && !stopRequested()) {
+      hs.setConfBudget(10000);
+      res = hs.solveLimited(assumptions);
+    }
+    if (res == l_Undef)
+      break;
+
+    if (res == l_False) {
+      lower_bound++;
+      core.clear();
+      for (int i = 0; i < hs.conflict.size(); i++) {
+        Lit q = hs.conflict[i];
+        std::map<Lit, int>::iterator it = bounded.find(q);
+        if (it == bounded.end())
+          relaxed[Minisat::var(q)] = true;
+        else {
+          int k = it->second;
+          Relaxation &r = relaxations[k];
+          bounded.erase(it);
+          if (++r.bound < (int)r.out.size())
+            bounded[r.out[r.bound]] = k;
+        }
+        core.push(q);
+      }
+      assert(core.size() > 0);
+      if (core.size() > 1) {
+        MinVec out;
+        totalizer(hs, core, out);
+        Relaxation r;
+        for (int i = 0; i < out.size(); i++)
+          r.out.push_back(out[i]);
+        r.bound = 1;
+        bounded[r.out[1]] = relaxations.size();
+        relaxations.push_back(r);
+      }
+      continue;
+    }
+    iterations++;
+
+    for (int i = 0; i < n_clauses; i++) {
+      bool keep = hs.model[i] == l_True;
+      if (keep != kept[i]) {
+        if (keep) sub.enableClause(i);
+        else sub.disableClause(i);
+        kept[i] = keep;
+      }
+    }
+
+    if (!findWitness(&full, &sub, cube, p)) {
+      found = !stopRequested();
+      break;
+    }
+
+    // Grows the kept clauses while the witness remains
+    clause.clear();
+    std::vector<int> grown;
+    for (int i = 0; i < n_clauses; i++) {
+      if (kept[i])
+        continue;
+      sub.enableClause(i);
+      if (derives(sub, cube, p)) {
+        sub.disableClause(i);
+        clause.push(selectors[i]);
+      } else
+        grown.push_back(i);
+    }
+    for (unsigned i = 0; i < grown.size(); i++)
+      sub.disableClause(grown[i]);
+
+    assert(clause.size() > 0);
+    hs.addClause(clause);
+  }
+
+  // Out of time or memory: the greedy minimization is used instead
+  if (!found) {
+    if (print)
+      std::cout << "c :: minimum encoding lower bound :: " << lower_bound << std::endl;
+    return minimize(s, print);
+  }
+
+  int n_kept = std::count(kept.begin(), kept.end(), true);
+  if (print) {
+    std::cout << "c :: minimum encoding iterations :: " << iterations << std::endl;
+    std::cout << "c :: minimum encoding lower bound :: " << lower_bound << std::endl;
+    printStats("optimal encoding", &full);
+    printf("c :: optimal minimal encoding :: %d\n", n_kept + full.nUnits());
+
+    printf("p cnf %d %d\n", o_vars, n_kept + full.nUnits());
+    full.printUnits();
+    for (int i = 0; i < n_clauses; i++)
+      if (kept[i])
+        full.printClause(i);
+  }
+  return n_kept + full.nUnits();
+}
@@ -0,0 +1,87 @@
+/************************************************************************************[ModelCache.cc]
+GenPCE -- Copyright (c) 2016, Ruben Martins, Martin Brain, Liana Hadarean, Daniel Kroening
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************/
+
+#include "ModelCache.h"
+
+using Minisat::lbool;
+
+void ModelCache::init(const Minisat::vec<Minisat::Lit>& inputs, unsigned _capacity) {
+  index.clear();
+  vars.clear();
+  for (int i = 0; i < inputs.size(); i++) {
+    Minisat::Var v = Minisat::var(inputs[i]);
+    if ((int)index.size() <= v) index.resize(v+1, -1);
+    if (index[v] == -1) {
+      index[v] = vars.size();
+      vars.push_back(v);
+    }
+  }
+
+  n_words = (vars.size() + 63) / 64;
+  if (n_words == 0) n_words = 1;
+  capacity = _capacity;
+  models.assign((size_t)capacity * n_words, 0);
+  clear();
+}
+
+void ModelCache::add(const Minisat::vec<Minisat::lbool>& model) {
+  uint64_t* m = &models[(size_t)next * n_words];
+  for (int i = 0; i < n_words; i++)
+    m[i] = 0;
+  for (unsigned p = 0; p < vars.size(); p++)
+    if (vars[p] < model.size() && model[vars[p]] == l_True)
+      m[p / 64] |= 1ULL << (p % 64);
+
+  next = (next + 1) % capacity;
+  if (n_models < capacity) n_models++;
+}
+
+bool ModelCache::satisfies(const StdVec& cube) {
+  if (n_models == 0)
+    return false;
+
+  // Assigned inputs and their values
+  std::vector<uint64_t> mask(n_words, 0), value(n_words, 0);
+  for (unsigned i = 0; i < cube.size(); i++) {
+    int p = index[Minisat::var(cube[i])];
+    mask[p / 64] |= 1ULL << (p % 64);
+    if (!Minisat::sign(cube[i])) value[p / 64] |= 1ULL << (p % 64);
+  }
+
+  // Consecutive cubes tend to be satisfied by the same model
+  for (unsigned k = 0; k < n_models; k++) {
+    unsigned slot = (last_hit + k) % n_models;
+    const uint64_t* m = &models[(size_t)slot * n_words];
+    bool sat = true;
+    for (int i = 0; i < n_words && sat; i++)
+      sat = ((m[i] ^ value[i]) & mask[i]) == 0;
+    if (sat) {
+      last_hit = slot;
+      return true;
+    }
+  }
+  return false;
+}
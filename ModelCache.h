@@ -0,0 +1,66 @@
+/*************************************************************************************[ModelCache.h]
+GenPCE -- Copyright (c) 2016, Ruben Martins, Martin Brain, Liana Hadarean, Daniel Kroening
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************/
+
+#ifndef ModelCache_h
+#define ModelCache_h
+
+#include "core/Solver.h"
+#include <vector>
+#include <stdint.h>
+
+typedef std::vector<Minisat::Lit> StdVec;
+
+// The values of the inputs in the most recent models of the reference.
+//
+// A cube that one of these models satisfies is satisfiable, so its SAT call
+// can be skipped. Models are stored as bit vectors (one bit per input) in a
+// ring buffer of fixed capacity, and a cube is tested against all of them
+// with a few word operations per model.
+class ModelCache {
+ public:
+  ModelCache() : n_words(0), capacity(0), n_models(0), next(0), last_hit(0) {}
+
+  void init(const Minisat::vec<Minisat::Lit>& inputs, unsigned _capacity = 64);
+  void clear() { n_models = 0; next = 0; last_hit = 0; }
+
+  // Stores the values of the inputs in 'model' (replaces the oldest model)
+  void add(const Minisat::vec<Minisat::lbool>& model);
+
+  // Returns true if a stored model satisfies every literal of 'cube'
+  bool satisfies(const StdVec& cube);
+
+ protected:
+  std::vector<int> index;         // Input position of each variable (-1 if not an input)
+  std::vector<Minisat::Var> vars; // Variable of each input position
+  int n_words;
+  unsigned capacity;
+  unsigned n_models;
+  unsigned next;                  // Slot of the next model to be stored
+  unsigned last_hit;              // Slot of the last model that satisfied a cube
+  std::vector<uint64_t> models;   // 'capacity' models of 'n_words' words each
+};
+
+#endif
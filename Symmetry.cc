@@ -0,0 +1,307 @@
+/**************************************************************************************[Symmetry.cc]
+GenPCE -- Copyright (c) 2016, Ruben Martins, Martin Brain, Liana Hadarean, Daniel Kroening
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************/
+
+#include "Symmetry.h"
+#include <algorithm>
+#include <set>
+#include <stdint.h>
+
+using namespace Minisat;
+
+namespace {
+
+// Undirected graph with an initial coloring of its vertices
+struct Graph {
+  std::vector<std::vector<int> > adj;
+  std::vector<int> color;
+
+  int size() const { return adj.size(); }
+  void edge(int u, int v) { adj[u].push_back(v); adj[v].push_back(u); }
+};
+
+uint64_t mix(uint64_t x) {
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  return x ^ (x >> 31);
+}
+
+// Splits the color classes by the colors of the neighbours until the coloring
+// is equitable. Colors are renumbered from 0 in a way that only depends on the
+// structure of the graph, so isomorphic colorings stay isomorphic. Returns the
+// number of colors.
+int refine(const Graph& g, std::vector<int>& color, int k) {
+  int n = g.size();
+  std::vector<std::pair<std::pair<int, uint64_t>, int> > sig(n);
+  if (n == 0)
+    return 0;
+
+  for (;;) {
+    for (int v = 0; v < n; v++) {
+      uint64_t h = 0;
+      for (unsigned i = 0; i < g.adj[v].size(); i++)
+        h += mix(color[g.adj[v][i]] + 1);
+      sig[v] = std::make_pair(std::make_pair(color[v], h), v);
+    }
+    std::sort(sig.begin(), sig.end());
+
+    int c = 0;
+    for (int i = 0; i < n; i++) {
+      if (i > 0 && sig[i].first != sig[i-1].first) c++;
+      color[sig[i].second] = c;
+    }
+    if (c + 1 == k)
+      return k;
+    k = c + 1;
+  }
+}
+
+// Both colorings have the same number of vertices of each color
+bool similar(const std::vector<int>& a, const std::vector<int>& b, int k) {
+  std::vector<int> count(k, 0);
+  for (unsigned v = 0; v < a.size(); v++) {
+    count[a[v]]++;
+    count[b[v]]--;
+  }
+  for (int c = 0; c < k; c++)
+    if (count[c] != 0) return false;
+  return true;
+}
+
+bool automorphism(const Graph& g, const std::vector<int>& perm) {
+  std::vector<int> mark(g.size(), -1);
+  for (int v = 0; v < g.size(); v++) {
+    int w = perm[v];
+    if (g.color[w] != g.color[v] || g.adj[w].size() != g.adj[v].size())
+      return false;
+    for (unsigned i = 0; i < g.adj[w].size(); i++)
+      mark[g.adj[w][i]] = v;
+    for (unsigned i = 0; i < g.adj[v].size(); i++)
+      if (mark[perm[g.adj[v][i]]] != v) return false;
+  }
+  return true;
+}
+
+// Looks for an automorphism mapping the vertices of each color of 'left' onto
+// the vertices of the same color of 'right'. Vertices are mapped onto
+// themselves first, which favours generators that move few vertices.
+struct Search {
+  const Graph& g;
+  int nodes;
+  std::vector<int> perm;
+
+  Search(const Graph& _g, int budget) : g(_g), nodes(budget) {}
+
+  bool run(const std::vector<int>& left, const std::vector<int>& right, int k) {
+    int n = g.size();
+    if (k == n) {
+      std::vector<int> vertex(n);
+      for (int v = 0; v < n; v++)
+        vertex[right[v]] = v;
+      perm.resize(n);
+      for (int v = 0; v < n; v++)
+        perm[v] = vertex[left[v]];
+      return automorphism(g, perm);
+    }
+
+    // Individualize a vertex of the first color class that is not a singleton
+    std::vector<int> count(k, 0);
+    for (int v = 0; v < n; v++)
+      count[left[v]]++;
+    int cell = 0;
+    while (count[cell] == 1)
+      cell++;
+    int x = 0;
+    while (left[x] != cell)
+      x++;
+
+    std::vector<int> candidates;
+    if (right[x] == cell)
+      candidates.push_back(x);
+    for (int y = 0; y < n; y++)
+      if (right[y] == cell && y != x)
+        candidates.push_back(y);
+
+    for (unsigned i = 0; i < candidates.size() && nodes > 0; i++) {
+      nodes--;
+      std::vector<int> l(left), r(right);
+      l[x] = k;
+      r[candidates[i]] = k;
+      int kl = refine(g, l, k + 1);
+      int kr = refine(g, r, k + 1);
+      if (kl == kr && similar(l, r, kl) && run(l, r, kl))
+        return true;
+    }
+    return false;
+  }
+};
+
+}
+
+void Symmetry::detect(Solver& s, const vec<Lit>& inputs, int budget) {
+  generators.clear();
+  index.assign(s.nVars(), -1);
+  input_vars.clear();
+  for (int i = 0; i < inputs.size(); i++) {
+    Var v = var(inputs[i]);
+    if (index[v] == -1) {
+      index[v] = input_vars.size();
+      input_vars.push_back(v);
+    }
+  }
+
+  // Literal vertices 2v and 2v+1, then one vertex per clause and per unit
+  vec<Lit> units, clause;
+  s.getUnits(units);
+  int n_lits = 2 * s.nVars();
+  Graph g;
+  g.adj.resize(n_lits + s.nClauses() + units.size());
+  g.color.resize(g.size());
+
+  for (Var v = 0; v < s.nVars(); v++) {
+    g.color[2*v] = index[v] == -1 ? 2 : 0;
+    g.color[2*v+1] = index[v] == -1 ? 3 : 1;
+    g.edge(2*v, 2*v+1);
+  }
+  for (int i = 0; i < s.nClauses(); i++) {
+    clause.clear();
+    s.getClause(i, clause);
+    g.color[n_lits + i] = 4 + clause.size();
+    for (int j = 0; j < clause.size(); j++)
+      g.edge(n_lits + i, toInt(clause[j]));
+  }
+  for (int i = 0; i < units.size(); i++) {
+    g.color[n_lits + s.nClauses() + i] = 5;
+    g.edge(n_lits + s.nClauses() + i, toInt(units[i]));
+  }
+
+  std::vector<int> base(g.color);
+  int k = refine(g, base, -1);
+
+  int n = input_vars.size();
+  for (int i = 0; i < n; i++) {
+    for (int j = i + 1; j < n; j++) {
+      int a = 2 * input_vars[i];
+      int b = 2 * input_vars[j];
+      if (base[a] != base[b])
+        continue;
+
+      std::vector<int> l(base), r(base);
+      l[a] = k;
+      r[b] = k;
+      int kl = refine(g, l, k + 1);
+      int kr = refine(g, r, k + 1);
+      Search search(g, budget);
+      if (kl != kr || !similar(l, r, kl) || !search.run(l, r, kl))
+        continue;
+
+      std::vector<int> gen(n), inverse(n);
+      for (int p = 0; p < n; p++) {
+        gen[p] = index[search.perm[2 * input_vars[p]] / 2];
+        inverse[gen[p]] = p;
+      }
+      if (std::find(generators.begin(), generators.end(), gen) == generators.end())
+        generators.push_back(gen);
+      if (std::find(generators.begin(), generators.end(), inverse) == generators.end())
+        generators.push_back(inverse);
+    }
+  }
+}
+
+void Symmetry::encode(const StdVec& cube, std::vector<char>& code) const {
+  code.assign(input_vars.size(), 0);
+  for (unsigned i = 0; i < cube.size(); i++)
+    code[index[var(cube[i])]] = sign(cube[i]) ? 2 : 1;
+}
+
+Lit Symmetry::apply(const std::vector<int>& g, Lit p) const {
+  Var v = var(p);
+  if (v >= (int)index.size() || index[v] == -1)
+    return p;
+  return mkLit(input_vars[g[index[v]]], sign(p));
+}
+
+void Symmetry::canonical(StdVec& cube) const {
+  std::vector<char> code, image(input_vars.size());
+  encode(cube, code);
+
+  // Smallest cube of the orbit when it is small enough to be enumerated
+  std::set<std::vector<char> > seen;
+  std::vector<std::vector<char> > queue(1, code);
+  seen.insert(code);
+  for (unsigned i = 0; i < queue.size() && queue.size() < max_orbit; i++) {
+    for (unsigned j = 0; j < generators.size(); j++) {
+      for (unsigned p = 0; p < image.size(); p++)
+        image[generators[j][p]] = queue[i][p];
+      if (seen.insert(image).second) {
+        queue.push_back(image);
+        if (image < code) code = image;
+      }
+    }
+  }
+
+  // Otherwise descend while some generator makes the cube smaller
+  bool smaller = queue.size() >= max_orbit;
+  while (smaller) {
+    smaller = false;
+    for (unsigned i = 0; i < generators.size(); i++) {
+      for (unsigned p = 0; p < code.size(); p++)
+        image[generators[i][p]] = code[p];
+      if (image < code) {
+        code.swap(image);
+        smaller = true;
+      }
+    }
+  }
+
+  cube.clear();
+  for (unsigned p = 0; p < code.size(); p++)
+    if (code[p] != 0)
+      cube.push_back(mkLit(input_vars[p], code[p] == 2));
+}
+
+void Symmetry::orbit(const vec<Lit>& clause, std::vector<StdVec>& images) const {
+  StdVec first;
+  for (int i = 0; i < clause.size(); i++)
+    first.push_back(clause[i]);
+  std::sort(first.begin(), first.end());
+
+  std::set<StdVec> seen;
+  images.clear();
+  images.push_back(first);
+  seen.insert(first);
+
+  for (unsigned i = 0; i < images.size(); i++) {
+    StdVec current = images[i];
+    for (unsigned j = 0; j < generators.size(); j++) {
+      StdVec image;
+      for (unsigned l = 0; l < current.size(); l++)
+        image.push_back(apply(generators[j], current[l]));
+      std::sort(image.begin(), image.end());
+      if (seen.insert(image).second)
+        images.push_back(image);
+    }
+  }
+}
@@ -0,0 +1,74 @@
+/***************************************************************************************[Symmetry.h]
+GenPCE -- Copyright (c) 2016, Ruben Martins, Martin Brain, Liana Hadarean, Daniel Kroening
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************/
+
+#ifndef Symmetry_h
+#define Symmetry_h
+
+#include "core/Solver.h"
+#include <vector>
+
+typedef std::vector<Minisat::Lit> StdVec;
+
+// Symmetries of a CNF formula that permute its input variables.
+//
+// The formula is turned into a colored graph (one vertex per literal and per
+// clause, with distinct colors for input and auxiliary literals of each sign)
+// and its automorphisms are found by individualization and color refinement.
+// Only their action on the inputs is kept, as a set of generators of the
+// symmetry group. Both cubes and clauses over the inputs are mapped with them.
+class Symmetry {
+ public:
+  Symmetry() {}
+
+  // Looks for a generator mapping each input onto each other input. The search
+  // for one pair of inputs gives up after 'budget' refinements.
+  void detect(Minisat::Solver& s, const Minisat::vec<Minisat::Lit>& inputs,
+              int budget = 200);
+  void clear() { generators.clear(); }
+
+  int size() const { return generators.size(); }
+
+  // Replaces 'cube' by the smallest cube of its orbit, or by a symmetric cube
+  // that no generator makes smaller when the orbit has more than 'max_orbit'
+  // cubes. The literals are returned in input order.
+  void canonical(StdVec& cube) const;
+
+  // Stores in 'images' every image of 'clause' under the symmetry group
+  // ('clause' included), with sorted literals.
+  void orbit(const Minisat::vec<Minisat::Lit>& clause, std::vector<StdVec>& images) const;
+
+ protected:
+  void encode(const StdVec& cube, std::vector<char>& code) const;
+  Minisat::Lit apply(const std::vector<int>& g, Minisat::Lit p) const;
+
+  static const unsigned max_orbit = 256;
+
+  std::vector<int> index;                   // Input position of each variable (-1 if not an input)
+  std::vector<Minisat::Var> input_vars;     // Variable of each input position
+  std::vector<std::vector<int> > generators; // Image position of each input position
+};
+
+#endif
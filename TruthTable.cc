@@ -0,0 +1,133 @@
+/************************************************************************************[TruthTable.cc]
+GenPCE -- Copyright (c) 2016, Ruben Martins, Martin Brain, Liana Hadarean, Daniel Kroening
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************/
+
+#include "TruthTable.h"
+
+using Minisat::lbool;
+
+// Mask of the bits of a word whose row has bit 'pos' (< 6) set
+static const uint64_t low_masks[6] = {
+  0xAAAAAAAAAAAAAAAAULL, 0xCCCCCCCCCCCCCCCCULL, 0xF0F0F0F0F0F0F0F0ULL,
+  0xFF00FF00FF00FF00ULL, 0xFFFF0000FFFF0000ULL, 0xFFFFFFFF00000000ULL
+};
+
+void TruthTable::clear() {
+  n_inputs = 0;
+  n_rows = 0;
+  index.clear();
+  rows.clear();
+}
+
+// Each model found is blocked on the inputs, so every row costs one SAT call.
+// The calls run under a conflict budget so that 'stop' is polled regularly.
+bool TruthTable::build(Minisat::Solver& reference, const Minisat::vec<Minisat::Lit>& inputs,
+                       const std::function<bool()>& stop) {
+  clear();
+  std::vector<Minisat::Var> vars;
+  for (int i = 0; i < inputs.size(); i++) {
+    Minisat::Var v = Minisat::var(inputs[i]);
+    if ((int)index.size() <= v) index.resize(v+1, -1);
+    if (index[v] == -1) {
+      index[v] = vars.size();
+      vars.push_back(v);
+    }
+  }
+  n_inputs = vars.size();
+  rows.assign(n_inputs > 6 ? (size_t)1 << (n_inputs - 6) : 1, 0);
+
+  Minisat::Solver s;
+  reference.cloneSolver(s);
+  Minisat::vec<Minisat::Lit> block, none;
+  for (;;) {
+    lbool res = l_Undef;
+    while (res == l_Undef && !stop()) {
+      s.setConfBudget(10000);
+      res = s.solveLimited(none);
+    }
+    if (res == l_Undef) {
+      clear();
+      return false;
+    }
+    if (res == l_False)
+      break;
+
+    uint64_t row = 0;
+    block.clear();
+    for (int i = 0; i < n_inputs; i++) {
+      bool value = s.model[vars[i]] == l_True;
+      if (value) row |= (uint64_t)1 << i;
+      block.push(Minisat::mkLit(vars[i], value));
+    }
+    rows[row >> 6] |= (uint64_t)1 << (row & 63);
+    n_rows++;
+    if (!s.addClause_(block))
+      break;
+  }
+  return true;
+}
+
+bool TruthTable::satisfiable(const StdVec& cube) const {
+  uint64_t low = ~0ULL;
+  uint64_t fixed = 0, value = 0;  // Word index bits set by the cube
+  for (unsigned i = 0; i < cube.size(); i++) {
+    int pos = index[Minisat::var(cube[i])];
+    bool positive = !Minisat::sign(cube[i]);
+    if (pos < 6)
+      low &= positive ? low_masks[pos] : ~low_masks[pos];
+    else {
+      uint64_t bit = (uint64_t)1 << (pos - 6);
+      if ((fixed & bit) && ((value & bit) != 0) != positive)
+        return false;
+      fixed |= bit;
+      if (positive) value |= bit;
+    }
+  }
+  if (low == 0)
+    return false;
+
+  // Visits the words that agree with the cube by enumerating the subsets of
+  // the free word index bits
+  uint64_t free = (rows.size() - 1) & ~fixed;
+  uint64_t subset = 0;
+  do {
+    if (rows[value | subset] & low)
+      return true;
+    subset = (subset - free) & free;
+  } while (subset != 0);
+  return false;
+}
+
+void TruthTable::shrink(StdVec& cube) const {
+  StdVec test;
+  for (unsigned i = 0; i < cube.size(); ) {
+    test.assign(cube.begin(), cube.begin() + i);
+    test.insert(test.end(), cube.begin() + i + 1, cube.end());
+    if (!satisfiable(test))
+      cube.swap(test);
+    else
+      i++;
+  }
+}
@@ -0,0 +1,70 @@
+/*************************************************************************************[TruthTable.h]
+GenPCE -- Copyright (c) 2016, Ruben Martins, Martin Brain, Liana Hadarean, Daniel Kroening
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************/
+
+#ifndef TruthTable_h
+#define TruthTable_h
+
+#include "core/Solver.h"
+#include <functional>
+#include <vector>
+#include <stdint.h>
+
+typedef std::vector<Minisat::Lit> StdVec;
+
+// The assignments of the inputs that extend to a model of the reference,
+// stored as a table of 2^inputs bits packed in 64-bit words.
+//
+// For gadgets with few inputs the table is enumerated once and replaces the
+// SAT calls of the search: a cube is satisfiable if a row of the table agrees
+// with it. The first six inputs select a bit of a word and are tested with a
+// constant mask, so only the words that agree with the cube on the other
+// inputs are visited.
+class TruthTable {
+ public:
+  TruthTable() : n_inputs(0), n_rows(0) {}
+
+  // Enumerates the rows of 'reference' projected onto 'inputs'. Returns false
+  // and leaves the table empty if 'stop' returns true before it is complete.
+  bool build(Minisat::Solver& reference, const Minisat::vec<Minisat::Lit>& inputs,
+             const std::function<bool()>& stop);
+  void clear();
+  bool empty() const { return rows.empty(); }
+  uint64_t size() const { return n_rows; }
+
+  // Returns true if some row agrees with every literal of 'cube'
+  bool satisfiable(const StdVec& cube) const;
+  // Removes literals from the unsatisfiable 'cube' until it is a minimal
+  // unsatisfiable cube (its negation is a prime implicate of the reference)
+  void shrink(StdVec& cube) const;
+
+ protected:
+  int n_inputs;
+  uint64_t n_rows;
+  std::vector<int> index;         // Input position of each variable (-1 if not an input)
+  std::vector<uint64_t> rows;     // Bit 'r' is set if row 'r' extends to a model
+};
+
+#endif
@@ -0,0 +1,96 @@
+/**************************************************************************************[Witness.cc]
+GenPCE -- Copyright (c) 2016, Ruben Martins, Martin Brain, Liana Hadarean, Daniel Kroening
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************/
+
+#include "GenPCE.h"
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <cstdlib>
+
+// A failed check prints one witness per line:
+//
+//   c witness <literals of the cube> 0 <implied literal> 0
+//
+// The cube implies the literal but the checked encoding does not propagate
+// it. A strengthen run given these lines as seeds only explores the
+// extensions of the witness cubes instead of every assignment. The clauses it
+// learns make unit propagation complete on each of these subtrees, and since
+// every incomplete assignment found by the check extends a witness, the
+// repaired encoding is complete once all witnesses of the check are seeds.
+// Lines that are not witnesses are ignored, so the output of the check can
+// be used as it is.
+
+// The cube must be a set of input literals without repeated or complementary
+// literals, and the implied literal must not be over a variable of the cube.
+bool GenPCE::loadSeeds(const char* file) {
+  std::ifstream in(file);
+  if (!in)
+    return false;
+
+  int n_vars = reference->nVars();
+  std::vector<bool> is_input(n_vars, false);
+  std::vector<bool> in_cube(n_vars, false);
+  for (int i = 0; i < inputs.size(); i++)
+    is_input[Minisat::var(inputs[i])] = true;
+
+  std::string line;
+  while (std::getline(in, line)) {
+    std::istringstream fields(line);
+    std::string c, tag;
+    if (!(fields >> c >> tag) || c != "c" || tag != "witness")
+      continue;
+
+    StdVec seed, implied;
+    int lit, zeros = 0;
+    while (zeros < 2 && fields >> lit) {
+      if (lit == 0)
+        zeros++;
+      else if (std::abs(lit) > n_vars)
+        return false;
+      else
+        (zeros == 0 ? seed : implied).push_back(Minisat::mkLit(std::abs(lit) - 1, lit < 0));
+    }
+    // The cube may be empty but the implied literal may not
+    if (zeros < 2 || implied.size() != 1)
+      return false;
+
+    bool valid = true;
+    for (unsigned i = 0; i < seed.size(); i++) {
+      Minisat::Var v = Minisat::var(seed[i]);
+      valid = valid && is_input[v] && !in_cube[v];
+      in_cube[v] = true;
+    }
+    valid = valid && !in_cube[Minisat::var(implied[0])];
+    for (unsigned i = 0; i < seed.size(); i++)
+      in_cube[Minisat::var(seed[i])] = false;
+    if (!valid)
+      return false;
+
+    seed.push_back(implied[0]);
+    seeds.push_back(seed);
+  }
+  return true;
+}
@@ -72,6 +72,13 @@ static void parse_DIMACS_main(B& in, Solver& S) {
                 eagerMatch(in, "i");
                 readClause(in, S, lits);
                 S.insertInput(lits);
+            // Split variables and cube of a job
+            } else if (*in == 's' && eagerMatch(in, "split")) {
+                readClause(in, S, lits);
+                S.insertSplit(lits);
+            } else if (*in == 'c' && eagerMatch(in, "cube")) {
+                readClause(in, S, lits);
+                S.insertCube(lits);
             // Outputs
             //} else if (*in == 'o') {
             //    eagerMatch(in, "o");
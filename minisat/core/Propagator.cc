@@ -0,0 +1,325 @@
+/************************************************************************************[Propagator.cc]
+GenPCE -- Copyright (c) 2016, Ruben Martins, Martin Brain, Liana Hadarean, Daniel Kroening
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************/
+
+
+#include "mtl/Sort.h"
+#include "core/Propagator.h"
+
+using namespace Minisat;
+
+Var Propagator::newVar()
+{
+    int v = nVars();
+    watches.push();
+    watches.push();
+    assigns.push(l_Undef);
+    mark   .push(0);
+    mark   .push(0);
+    trail  .capacity(v+1);
+    return v;
+}
+
+
+bool Propagator::addClause(const vec<Lit>& clause)
+{
+    cancelUntil(0);
+    if (!ok) return false;
+
+    // Check if clause is satisfied and remove false/duplicate literals:
+    vec<Lit> ps;
+    clause.copyTo(ps);
+    sort(ps);
+    Lit p; int i, j;
+    for (i = j = 0, p = lit_Undef; i < ps.size(); i++)
+        if (value(ps[i]) == l_True || ps[i] == ~p)
+            return true;
+        else if (value(ps[i]) != l_False && ps[i] != p)
+            ps[j++] = p = ps[i];
+    ps.shrink(i - j);
+
+    if (ps.size() == 0)
+        return ok = false;
+    else if (ps.size() == 1){
+        enqueue(ps[0]);
+        return ok = propagate();
+    }else if (ps.size() == 2){
+        watches[toInt(~ps[0])].push(Watch(ps[1], binary));
+        watches[toInt(~ps[1])].push(Watch(ps[0], binary));
+    }else if (ps.size() == 3){
+        for (i = 0; i < 3; i++)
+            watches[toInt(~ps[i])].push(Watch(ps[i == 0], ternary | toInt(ps[i == 2 ? 1 : 2])));
+    }else{
+        uint32_t cr = lits.size();
+        lits.push(toLit(ps.size()));
+        for (i = 0; i < ps.size(); i++)
+            lits.push(ps[i]);
+        attachLong(cr);
+    }
+
+    return true;
+}
+
+
+void Propagator::attachLong(uint32_t cr)
+{
+    const Lit* c = &lits[cr + 1];
+    watches[toInt(~c[0])].push(Watch(c[1], cr));
+    watches[toInt(~c[1])].push(Watch(c[0], cr));
+}
+
+
+// The literals of the clause being removed are marked
+bool Propagator::sameClause(uint32_t cr, int size) const
+{
+    if (toInt(lits[cr]) != size)
+        return false;
+    for (int i = 1; i <= size; i++)
+        if (!mark[toInt(lits[cr + i])])
+            return false;
+    return true;
+}
+
+
+void Propagator::removeClause(const Clause& c)
+{
+    cancelUntil(0);
+    int i, j;
+    for (i = 0; i < c.size(); i++)
+        mark[toInt(c[i])] = 1;
+
+    // Short clauses are watched by all their literals
+    bool found = false;
+    for (i = 0; i < c.size() && (c.size() <= 3 || !found); i++){
+        vec<Watch>& ws = watches[toInt(~c[i])];
+        for (j = 0; j < ws.size(); j++){
+            const Watch& w = ws[j];
+            bool same;
+            if (isBinary(w))
+                same = c.size() == 2 && mark[toInt(w.blocker)];
+            else if (isTernary(w))
+                same = c.size() == 3 && mark[toInt(w.blocker)] && mark[w.data & ~ternary];
+            else
+                same = c.size() > 3 && sameClause(w.data, c.size());
+            if (!same)
+                continue;
+
+            // Long clauses are detached lazily by 'propagate'
+            if (c.size() > 3){
+                lits[w.data] = toLit(-c.size());
+                wasted += c.size() + 1;
+            }else
+                ws[j] = ws.last(), ws.pop();
+            found = true;
+            break;
+        }
+    }
+
+    for (i = 0; i < c.size(); i++)
+        mark[toInt(c[i])] = 0;
+
+    if (wasted > lits.size() / 2)
+        compact();
+}
+
+
+// Drops the removed long clauses, which must be done at the root level
+void Propagator::compact()
+{
+    assert(decisionLevel() == 0);
+    for (int i = 0; i < watches.size(); i++){
+        vec<Watch>& ws = watches[i];
+        int j = 0;
+        for (int k = 0; k < ws.size(); k++)
+            if (isBinary(ws[k]) || isTernary(ws[k]))
+                ws[j++] = ws[k];
+        ws.shrink(ws.size() - j);
+    }
+
+    vec<Lit> old;
+    lits.moveTo(old);
+    for (int cr = 0, size; cr < old.size(); cr += size + 1){
+        size = toInt(old[cr]);
+        if (size < 0){
+            size = -size; continue; }
+        uint32_t to = lits.size();
+        for (int i = 0; i <= size; i++)
+            lits.push(old[cr + i]);
+        attachLong(to);
+    }
+    wasted = 0;
+}
+
+
+void Propagator::clear()
+{
+    cancelUntil(0);
+    for (int i = 0; i < trail.size(); i++)
+        assigns[var(trail[i])] = l_Undef;
+    trail.clear();
+    qhead = 0;
+    for (int i = 0; i < watches.size(); i++)
+        watches[i].clear();
+    lits.clear();
+    wasted = 0;
+    ok = true;
+}
+
+
+void Propagator::cancelUntil(int level)
+{
+    if (decisionLevel() > level){
+        for (int c = trail.size()-1; c >= trail_lim[level]; c--)
+            assigns[var(trail[c])] = l_Undef;
+        qhead = trail_lim[level];
+        trail.shrink(trail.size() - trail_lim[level]);
+        trail_lim.shrink(trail_lim.size() - level);
+        assumptions.shrink(assumptions.size() - level);
+    }
+    up_conflict = false;
+}
+
+
+/*_________________________________________________________________________________________________
+|
+|  propagate : [void]  ->  [bool]
+|  
+|  Description:
+|    Propagates all enqueued facts. Returns FALSE if a conflict arises.
+|  
+|    Post-conditions:
+|      * the propagation queue is empty, even if there was a conflict.
+|________________________________________________________________________________________________@*/
+bool Propagator::propagate()
+{
+    while (qhead < trail.size()){
+        Lit          p  = trail[qhead++];     // 'p' is enqueued fact to propagate.
+        vec<Watch>&  ws = watches[toInt(p)];
+        Watch        *i, *j, *end;
+        bool         confl = false;
+
+        for (i = j = (Watch*)ws, end = i + ws.size();  i != end;){
+            Watch w = *i++;
+            lbool b = value(w.blocker);
+
+            if (isBinary(w)){
+                *j++ = w;
+                if (b == l_Undef)      enqueue(w.blocker);
+                else if (b == l_False) confl = true;
+            }else if (w.data & ternary){
+                *j++ = w;
+                Lit   q = toLit(w.data & ~ternary);
+                lbool v = value(q);
+                if (b == l_True || v == l_True) continue;
+                if (b == l_False && v == l_False) confl = true;
+                else if (b == l_False)            enqueue(q);
+                else if (v == l_False)            enqueue(w.blocker);
+            }else{
+                // Try to avoid inspecting the clause:
+                if (b == l_True){
+                    *j++ = w; continue; }
+
+                int size = toInt(lits[w.data]);
+                if (size < 0) continue;    // Removed clause
+
+                // Make sure the false literal is c[1]:
+                Lit* c         = &lits[w.data + 1];
+                Lit  false_lit = ~p;
+                if (c[0] == false_lit)
+                    c[0] = c[1], c[1] = false_lit;
+
+                // If 0th watch is true, then clause is already satisfied.
+                Lit first = c[0];
+                Watch nw  = Watch(first, w.data);
+                if (first != w.blocker && value(first) == l_True){
+                    *j++ = nw; continue; }
+
+                // Look for new watch:
+                for (int k = 2; k < size; k++)
+                    if (value(c[k]) != l_False){
+                        c[1] = c[k]; c[k] = false_lit;
+                        watches[toInt(~c[1])].push(nw);
+                        goto NextClause; }
+
+                // Did not find watch -- clause is unit under assignment:
+                *j++ = nw;
+                if (value(first) == l_False) confl = true;
+                else                         enqueue(first);
+            NextClause:;
+            }
+
+            if (confl){
+                // Copy the remaining watches:
+                while (i < end)
+                    *j++ = *i++;
+                ws.shrink(i - j);
+                qhead = trail.size();
+                return false;
+            }
+        }
+        ws.shrink(i - j);
+    }
+
+    return true;
+}
+
+
+/*_________________________________________________________________________________________________
+|
+|  up : (assumps : const vec<Lit>&)  ->  [bool]
+|  
+|  Description:
+|    Unit propagates the assumptions one decision level per assumption, keeping the decision levels
+|    of the previous call whose assumptions match 'assumps'. Returns FALSE on a conflict.
+|________________________________________________________________________________________________@*/
+bool Propagator::up(const vec<Lit>& assumps)
+{
+    if (!ok) return false;
+
+    // The last level of a conflicting call was not fully propagated
+    int reuse = up_conflict ? decisionLevel() - 1 : decisionLevel();
+    int level = 0;
+    while (level < reuse && level < assumps.size() && assumptions[level] == assumps[level])
+        level++;
+    cancelUntil(level);
+
+    for (; level < assumps.size(); level++){
+        Lit p = assumps[level];
+        if (value(p) == l_False)
+            return false;
+
+        trail_lim.push(trail.size());
+        assumptions.push(p);
+        if (value(p) == l_Undef){
+            enqueue(p);
+            if (!propagate()){
+                up_conflict = true;
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,100 @@
+/*************************************************************************************[Propagator.h]
+GenPCE -- Copyright (c) 2016, Ruben Martins, Martin Brain, Liana Hadarean, Daniel Kroening
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************/
+
+
+#ifndef Minisat_Propagator_h
+#define Minisat_Propagator_h
+
+#include "mtl/Vec.h"
+#include "core/SolverTypes.h"
+
+namespace Minisat {
+
+//=================================================================================================
+// Propagator -- unit propagation over a set of problem clauses, without search:
+//
+// Binary and ternary clauses are only stored in the watch lists of their literals, so propagating
+// them does not touch clause memory. Longer clauses are stored one after the other in 'lits' and
+// watched by their first two literals. As in 'Solver::up', every assumption gets its own decision
+// level and the levels shared with the previous call are kept.
+
+class Propagator {
+public:
+    Propagator() : ok(true), up_conflict(false), qhead(0), wasted(0) {}
+
+    Var  newVar      ();
+    int  nVars       () const { return assigns.size(); }
+    bool okay        () const { return ok; }
+
+    bool addClause   (const vec<Lit>& ps);     // Adds a clause at the root level (FALSE if the clauses are contradictory).
+    void removeClause(const Clause& c);        // Removes a clause added before with the same literals.
+    void clear       ();                       // Removes all clauses and root-level assignments (keeps the variables).
+
+    bool up          (const vec<Lit>& assumps); // Unit propagate from a given set of assumptions (reuses the common prefix)
+    const vec<Lit>& getTrail() const { return trail; }
+
+    lbool value      (Var x) const { return assigns[x]; }
+    lbool value      (Lit p) const { return assigns[var(p)] ^ sign(p); }
+
+protected:
+    // A binary watch holds the other literal of the clause and a ternary watch the other two. A
+    // long watch holds a blocker literal and the position of the clause in 'lits'.
+    struct Watch {
+        Lit      blocker;
+        uint32_t data;
+        Watch(Lit p, uint32_t d) : blocker(p), data(d) {}
+    };
+    static const uint32_t binary  = 0xFFFFFFFF;  // 'data' of a binary watch.
+    static const uint32_t ternary = 0x80000000;  // Flag of a ternary watch ('data' is the third literal).
+
+    static bool isBinary (const Watch& w) { return w.data == binary; }
+    static bool isTernary(const Watch& w) { return w.data != binary && (w.data & ternary); }
+
+    bool ok;                    // FALSE if the clauses are contradictory.
+    bool up_conflict;           // The last call to 'up' stopped on a conflict.
+    vec<lbool> assigns;         // The current assignments.
+    vec<Lit> trail;             // Assignment stack.
+    vec<int> trail_lim;         // Separator indices for different decision levels in 'trail'.
+    vec<Lit> assumptions;       // Assumption of each decision level.
+    int qhead;                  // Head of queue (as index into the trail).
+    vec<vec<Watch> > watches;   // Watches of the clauses containing '~p', indexed by 'toInt(p)'.
+    vec<Lit> lits;              // Long clauses: a size (negative once removed), then the literals.
+    int wasted;                 // Entries of 'lits' used by removed clauses.
+    vec<char> mark;             // Literals of the clause being removed.
+
+    int  decisionLevel() const { return trail_lim.size(); }
+    void enqueue      (Lit p) { assigns[var(p)] = lbool(!sign(p)); trail.push_(p); }
+    void cancelUntil  (int level);
+    bool propagate    ();
+    void attachLong   (uint32_t cr);
+    bool sameClause   (uint32_t cr, int size) const;
+    void compact      ();
+};
+
+//=================================================================================================
+}
+
+#endif
@@ -83,6 +83,7 @@ Solver::Solver() :
   , cla_inc            (1)
   , var_inc            (1)
   , watches            (WatcherDeleted(ca))
+  , learnt_watches     (WatcherDeleted(ca))
   , qhead              (0)
   , simpDB_assigns     (-1)
   , simpDB_props       (0)
@@ -97,11 +98,16 @@ Solver::Solver() :
   , asynch_interrupt   (false)
 {
     assumption_vars = -1;
+    up_conflict = false;
+    subsume = false;
+    n_subsumed = 0;
+    propagator = NULL;
 }
 
 
 Solver::~Solver()
 {
+    delete propagator;
 }
 
 
@@ -117,6 +123,8 @@ Var Solver::newVar(bool sign, bool dvar)
     int v = nVars();
     watches  .init(mkLit(v, false));
     watches  .init(mkLit(v, true ));
+    learnt_watches.init(mkLit(v, false));
+    learnt_watches.init(mkLit(v, true ));
     assigns  .push(l_Undef);
     vardata  .push(mkVarData(CRef_Undef, 0));
     //activity .push(0);
@@ -126,6 +134,7 @@ Var Solver::newVar(bool sign, bool dvar)
     decision .push();
     trail    .capacity(v+1);
     setDecisionVar(v, dvar);
+    if (propagator) propagator->newVar();
     return v;
 }
 
@@ -145,6 +154,7 @@ bool Solver::addClause_(vec<Lit>& ps)
             ps[j++] = p = ps[i];
     ps.shrink(i - j);
 
+    if (propagator) propagator->addClause(ps);
     if (ps.size() == 0)
         return ok = false;
     else if (ps.size() == 1){
@@ -160,11 +170,216 @@ bool Solver::addClause_(vec<Lit>& ps)
 }
 
 
+void Solver::setSubsumption(bool enable)
+{
+    // 'simplify' must not free the problem clauses referenced by the
+    // occurrence lists (as in 'SimpSolver')
+    subsume = enable;
+    remove_satisfied = !enable;
+    occs.clear(true);
+    if (!enable) return;
+
+    occs.growTo(2 * nVars());
+    for (int i = 0; i < clauses.size(); i++)
+        attachOccs(clauses[i]);
+}
+
+
+void Solver::setPropagator(bool enable)
+{
+    if (enable == (propagator != NULL)) return;
+    delete propagator;
+    propagator = NULL;
+    if (!enable) return;
+
+    propagator = new Propagator();
+    while (propagator->nVars() < nVars())
+        propagator->newVar();
+    cancelUntil(0);
+    vec<Lit> ps;
+    if (!ok) propagator->addClause(ps);
+    for (int i = 0; i < trail.size(); i++){
+        ps.clear();
+        ps.push(trail[i]);
+        propagator->addClause(ps);
+    }
+    for (int i = 0; i < clauses.size(); i++){
+        const Clause& c = ca[clauses[i]];
+        ps.clear();
+        for (int j = 0; j < c.size(); j++)
+            ps.push(c[j]);
+        propagator->addClause(ps);
+    }
+}
+
+
+void Solver::reset()
+{
+    cancelUntil(0);
+    for (int i = 0; i < trail.size(); i++){
+        Var v = var(trail[i]);
+        assigns[v] = l_Undef;
+        vardata[v] = mkVarData(CRef_Undef, 0);
+        insertVarOrder(v);
+    }
+    trail.clear();
+    qhead = 0;
+
+    // The lazily deleted watchers must be removed while the arena is valid
+    watches.cleanAll();
+    learnt_watches.cleanAll();
+    for (int v = 0; v < nVars(); v++)
+        for (int s = 0; s < 2; s++){
+            watches[mkLit(v, s)].clear();
+            learnt_watches[mkLit(v, s)].clear();
+        }
+    for (int i = 0; i < occs.size(); i++)
+        occs[i].clear();
+    if (propagator) propagator->clear();
+    clauses.clear();
+    learnts.clear();
+    ca.clear();
+
+    ok = true;
+    assumptions.clear();
+    list_reason.clear();
+    up_conflict = false;
+    n_subsumed = 0;
+    simpDB_assigns = -1;
+    simpDB_props = 0;
+    clauses_literals = learnts_literals = 0;
+}
+
+
+void Solver::attachOccs(CRef cr)
+{
+    const Clause& c = ca[cr];
+    for (int i = 0; i < c.size(); i++)
+        occs[toInt(c[i])].push(cr);
+}
+
+
+// Removes a problem clause, keeping the order of the others
+void Solver::removeSubsumed(CRef cr)
+{
+    const Clause& c = ca[cr];
+    for (int i = 0; i < c.size(); i++)
+        remove(occs[toInt(c[i])], cr);
+    if (propagator) propagator->removeClause(c);
+    remove(clauses, cr);
+    removeClause(cr);
+    n_subsumed++;
+}
+
+
+int Solver::countMarked(const Clause& c) const
+{
+    int n = 0;
+    for (int i = 0; i < c.size(); i++)
+        n += subsume_mark[toInt(c[i])];
+    return n;
+}
+
+
+bool Solver::addClauseSubsume(vec<Lit>& ps, vec<vec<Lit> >* out)
+{
+    assert(decisionLevel() == 0);
+    if (!ok) return false;
+
+    // Check if clause is satisfied and remove false/duplicate literals:
+    sort(ps);
+    Lit p; int i, j;
+    for (i = j = 0, p = lit_Undef; i < ps.size(); i++)
+        if (value(ps[i]) == l_True || ps[i] == ~p)
+            return true;
+        else if (value(ps[i]) != l_False && ps[i] != p)
+            ps[j++] = p = ps[i];
+    ps.shrink(i - j);
+
+    if (ps.size() == 0)
+        return ok = false;
+
+    occs.growTo(2 * nVars());
+    subsume_mark.growTo(2 * nVars(), 0);
+    for (i = 0; i < ps.size(); i++)
+        subsume_mark[toInt(ps[i])] = 1;
+
+    // Backward subsumption: an existing clause subsumes 'ps'
+    bool subsumed = false;
+    for (i = 0; i < ps.size() && !subsumed; i++){
+        const vec<CRef>& os = occs[toInt(ps[i])];
+        for (j = 0; j < os.size() && !subsumed; j++){
+            const Clause& c = ca[os[j]];
+            subsumed = c.size() <= ps.size() && countMarked(c) == c.size();
+        }
+    }
+
+    vec<CRef> removed;
+    vec<vec<Lit> > strengthened;
+    if (!subsumed){
+        // Forward subsumption: the clauses containing all of 'ps' also contain
+        // the literal of 'ps' with the fewest occurrences
+        int best = 0;
+        for (i = 1; i < ps.size(); i++)
+            if (occs[toInt(ps[i])].size() < occs[toInt(ps[best])].size())
+                best = i;
+        const vec<CRef>& os = occs[toInt(ps[best])];
+        for (j = 0; j < os.size(); j++)
+            if (ca[os[j]].size() >= ps.size() && countMarked(ca[os[j]]) == ps.size())
+                removed.push(os[j]);
+
+        // Self-subsumption: 'c' contains ~ps[i] and the rest of 'ps', so
+        // resolving it with 'ps' removes ~ps[i]
+        for (i = 0; i < ps.size(); i++){
+            const vec<CRef>& ns = occs[toInt(~ps[i])];
+            for (j = 0; j < ns.size(); j++){
+                const Clause& c = ca[ns[j]];
+                if (c.size() < ps.size() || countMarked(c) != ps.size() - 1)
+                    continue;
+                removed.push(ns[j]);
+                strengthened.push();
+                for (int k = 0; k < c.size(); k++)
+                    if (c[k] != ~ps[i])
+                        strengthened.last().push(c[k]);
+            }
+        }
+    }
+
+    for (i = 0; i < ps.size(); i++)
+        subsume_mark[toInt(ps[i])] = 0;
+
+    if (subsumed){
+        n_subsumed++;
+        return true;
+    }
+
+    for (i = 0; i < removed.size(); i++)
+        removeSubsumed(removed[i]);
+
+    int n_clauses = clauses.size();
+    if (!addClause_(ps))
+        return false;
+    if (clauses.size() > n_clauses)
+        attachOccs(clauses.last());
+
+    for (i = 0; i < strengthened.size() && ok; i++){
+        if (out != NULL){
+            out->push();
+            strengthened[i].copyTo(out->last());
+        }
+        addClauseSubsume(strengthened[i], out);
+    }
+
+    return ok;
+}
+
+
 void Solver::attachClause(CRef cr) {
     const Clause& c = ca[cr];
     assert(c.size() > 1);
-    watches[~c[0]].push(Watcher(cr, c[1]));
-    watches[~c[1]].push(Watcher(cr, c[0]));
+    OccLists<Lit, vec<Watcher>, WatcherDeleted>& ws = c.learnt() ? learnt_watches : watches;
+    ws[~c[0]].push(Watcher(cr, c[1]));
+    ws[~c[1]].push(Watcher(cr, c[0]));
     if (c.learnt()) learnts_literals += c.size();
     else            clauses_literals += c.size(); }
 
@@ -172,14 +387,15 @@ void Solver::attachClause(CRef cr) {
 void Solver::detachClause(CRef cr, bool strict) {
     const Clause& c = ca[cr];
     assert(c.size() > 1);
+    OccLists<Lit, vec<Watcher>, WatcherDeleted>& ws = c.learnt() ? learnt_watches : watches;
     
     if (strict){
-        remove(watches[~c[0]], Watcher(cr, c[1]));
-        remove(watches[~c[1]], Watcher(cr, c[0]));
+        remove(ws[~c[0]], Watcher(cr, c[1]));
+        remove(ws[~c[1]], Watcher(cr, c[0]));
     }else{
         // Lazy detaching: (NOTE! Must clean all watcher lists before garbage collecting this clause)
-        watches.smudge(~c[0]);
-        watches.smudge(~c[1]);
+        ws.smudge(~c[0]);
+        ws.smudge(~c[1]);
     }
 
     if (c.learnt()) learnts_literals -= c.size();
@@ -442,65 +658,72 @@ void Solver::uncheckedEnqueue(Lit p, CRef from)
 |  
 |  Description:
 |    Propagates all enqueued facts. If a conflict arises, the conflicting clause is returned,
-|    otherwise CRef_Undef.
+|    otherwise CRef_Undef. Learnt clauses are only used if 'use_learnts' is set; 'up' does not use
+|    them so that its result only depends on the problem clauses.
 |  
 |    Post-conditions:
 |      * the propagation queue is empty, even if there was a conflict.
 |________________________________________________________________________________________________@*/
-CRef Solver::propagate()
+CRef Solver::propagate(bool use_learnts)
 {
     CRef    confl     = CRef_Undef;
     int     num_props = 0;
     watches.cleanAll();
+    if (use_learnts) learnt_watches.cleanAll();
 
     while (qhead < trail.size()){
         Lit            p   = trail[qhead++];     // 'p' is enqueued fact to propagate.
-        vec<Watcher>&  ws  = watches[p];
-        Watcher        *i, *j, *end;
         num_props++;
 
-        for (i = j = (Watcher*)ws, end = i + ws.size();  i != end;){
-            // Try to avoid inspecting the clause:
-            Lit blocker = i->blocker;
-            if (value(blocker) == l_True){
-                *j++ = *i++; continue; }
-
-            // Make sure the false literal is data[1]:
-            CRef     cr        = i->cref;
-            Clause&  c         = ca[cr];
-            Lit      false_lit = ~p;
-            if (c[0] == false_lit)
-                c[0] = c[1], c[1] = false_lit;
-            assert(c[1] == false_lit);
-            i++;
-
-            // If 0th watch is true, then clause is already satisfied.
-            Lit     first = c[0];
-            Watcher w     = Watcher(cr, first);
-            if (first != blocker && value(first) == l_True){
-                *j++ = w; continue; }
-
-            // Look for new watch:
-            for (int k = 2; k < c.size(); k++)
-                if (value(c[k]) != l_False){
-                    c[1] = c[k]; c[k] = false_lit;
-                    watches[~c[1]].push(w);
-                    goto NextClause; }
-
-            // Did not find watch -- clause is unit under assignment:
-            *j++ = w;
-            if (value(first) == l_False){
-                confl = cr;
-                qhead = trail.size();
-                // Copy the remaining watches:
-                while (i < end)
-                    *j++ = *i++;
-            }else
-                uncheckedEnqueue(first, cr);
-
-        NextClause:;
+        // Problem clauses first, then learnt clauses (unless a conflict was found):
+        for (int l = 0; l < (use_learnts ? 2 : 1) && confl == CRef_Undef; l++){
+            OccLists<Lit, vec<Watcher>, WatcherDeleted>& wl = l == 0 ? watches : learnt_watches;
+            vec<Watcher>&  ws  = wl[p];
+            Watcher        *i, *j, *end;
+
+            for (i = j = (Watcher*)ws, end = i + ws.size();  i != end;){
+                // Try to avoid inspecting the clause:
+                Lit blocker = i->blocker;
+                if (value(blocker) == l_True){
+                    *j++ = *i++; continue; }
+
+                // Make sure the false literal is data[1]:
+                CRef     cr        = i->cref;
+                Clause&  c         = ca[cr];
+                Lit      false_lit = ~p;
+                if (c[0] == false_lit)
+                    c[0] = c[1], c[1] = false_lit;
+                assert(c[1] == false_lit);
+                i++;
+
+                // If 0th watch is true, then clause is already satisfied.
+                Lit     first = c[0];
+                Watcher w     = Watcher(cr, first);
+                if (first != blocker && value(first) == l_True){
+                    *j++ = w; continue; }
+
+                // Look for new watch:
+                for (int k = 2; k < c.size(); k++)
+                    if (value(c[k]) != l_False){
+                        c[1] = c[k]; c[k] = false_lit;
+                        wl[~c[1]].push(w);
+                        goto NextClause; }
+
+                // Did not find watch -- clause is unit under assignment:
+                *j++ = w;
+                if (value(first) == l_False){
+                    confl = cr;
+                    qhead = trail.size();
+                    // Copy the remaining watches:
+                    while (i < end)
+                        *j++ = *i++;
+                }else
+                    uncheckedEnqueue(first, cr);
+
+            NextClause:;
+            }
+            ws.shrink(i - j);
         }
-        ws.shrink(i - j);
     }
     propagations += num_props;
     simpDB_props -= num_props;
@@ -797,26 +1020,37 @@ lbool Solver::solve_()
 
 
 
+/*_________________________________________________________________________________________________
+|
+|  up : (assumps : const vec<Lit>&)  ->  [bool]
+|  
+|  Description:
+|    Unit propagates the assumptions one decision level per assumption. The decision levels left by
+|    the previous call are reused as long as their assumptions match 'assumps', so only the suffix
+|    that differs from the previous call is propagated again.
+|________________________________________________________________________________________________@*/
 bool Solver::up (const vec<Lit>& assumps) {
+  if (propagator) return propagator->up(assumps);
+
   /* From solve() */
   budgetOff();
+
+  // The last level of a conflicting call was not fully propagated
+  int reuse = up_conflict ? decisionLevel() - 1 : decisionLevel();
+  int level = 0;
+  while (level < reuse && level < assumps.size() && assumptions[level] == assumps[level])
+    level++;
+  cancelUntil(level);
+  up_conflict = false;
+
   assumps.copyTo(assumptions);
   // return solve_() == l_True;
 
-  cancelUntil(0);
-  //assert (decisionLevel() == 0);
-
   /* Form solve_()*/
   model.clear();
   conflict.clear();
 
-  /* Need to remove the learnt clauses */
-  for (int i = 0; i < learnts.size(); i++){
-    removeClause(learnts[i]);
-  }
-  //learnts.shrink(0);
-  learnts.clear();
-  checkGarbage();
+  /* Learnt clauses are kept for 'solve' but are not used for propagation */
 
   if (!ok){
     //printf("conflict in the state of the solver\n");
@@ -835,10 +1069,12 @@ bool Solver::up (const vec<Lit>& assumps) {
   starts++;
   
   for (;;){
-    CRef confl = propagate();
+    CRef confl = propagate(false);
     if (confl != CRef_Undef){
       //cancelUntil(0);
         //printf("conflict in propagations\n");
+      if (decisionLevel() == 0) ok = false;
+      up_conflict = true;
 	  return false;
 
     }else{
@@ -967,6 +1203,7 @@ void Solver::relocAll(ClauseAllocator& to)
     //
     // for (int i = 0; i < watches.size(); i++)
     watches.cleanAll();
+    learnt_watches.cleanAll();
     for (int v = 0; v < nVars(); v++)
         for (int s = 0; s < 2; s++){
             Lit p = mkLit(v, s);
@@ -974,6 +1211,9 @@ void Solver::relocAll(ClauseAllocator& to)
             vec<Watcher>& ws = watches[p];
             for (int j = 0; j < ws.size(); j++)
                 ca.reloc(ws[j].cref, to);
+            vec<Watcher>& lws = learnt_watches[p];
+            for (int j = 0; j < lws.size(); j++)
+                ca.reloc(lws[j].cref, to);
         }
 
     // All reasons:
@@ -994,6 +1234,12 @@ void Solver::relocAll(ClauseAllocator& to)
     //
     for (int i = 0; i < clauses.size(); i++)
         ca.reloc(clauses[i], to);
+
+    // Occurrence lists:
+    //
+    for (int i = 0; i < occs.size(); i++)
+        for (int j = 0; j < occs[i].size(); j++)
+            ca.reloc(occs[i][j], to);
 }
 
 
@@ -26,6 +26,7 @@ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWA
 #include "mtl/Alg.h"
 #include "utils/Options.h"
 #include "core/SolverTypes.h"
+#include "core/Propagator.h"
 #include "mtl/Sort.h"
 
 namespace Minisat {
@@ -44,7 +45,35 @@ public:
     // Optimal-finder:
     // 
     // Backtracks to root level before adding a clause
-    bool addClause__(vec<Lit>& ps) { cancelUntil(0); return addClause_(ps); }
+    bool addClause__(vec<Lit>& ps, vec<vec<Lit> >* strengthened = NULL) {
+        cancelUntil(0); return subsume ? addClauseSubsume(ps, strengthened) : addClause_(ps); }
+
+    // Keeps the problem clauses free of subsumed clauses: 'addClause__' rejects
+    // a clause subsumed by an existing one, removes the clauses it subsumes and
+    // strengthens the clauses it subsumes by self-subsuming resolution. The
+    // strengthened clauses are appended to 'strengthened' (when given), since
+    // they are stronger under unit propagation than the clauses they replace.
+    // While enabled, 'simplify' keeps the satisfied problem clauses.
+    void setSubsumption(bool enable);
+    int nSubsumed() const { return n_subsumed; }
+
+    // Serves 'up' and 'getTrail' from a 'Propagator' that holds a copy of the
+    // problem clauses, for solvers that only learn clauses and propagate. The
+    // copy follows 'addClause_' and the clauses removed by subsumption, and
+    // 'disableClause'/'enableClause' can not be used with it.
+    void setPropagator(bool enable);
+
+    // Removes every clause and root-level assignment. The variables and the
+    // memory of the clause arena, watch lists and trail are kept, so that the
+    // solver can hold another encoding over the same variables.
+    void reset();
+
+    // Takes the problem clause 'i' out of unit propagation or puts it back.
+    // The root-level assignment is kept, so the clause must not be the reason
+    // of a root-level literal ('isRootReason').
+    void disableClause(int i) { assert(propagator == NULL); cancelUntil(0); detachClause(clauses[i], true); }
+    void enableClause(int i) { assert(propagator == NULL); cancelUntil(0); attachClause(clauses[i]); }
+    bool isRootReason(int i) { cancelUntil(0); return locked(ca[clauses[i]]); }
 
     bool is_locked(int i) { 
         assert (i < nClauses());
@@ -65,6 +94,17 @@ public:
         }
     }
 
+    // Whether 'v' is assigned after the last call to 'up', read from 'assigns'
+    // instead of the trail. With 'lock' the clause that implied 'v' is marked
+    // as by 'lock_reason' (only without 'setPropagator', which keeps no reasons).
+    bool implied(Var v, bool lock = false) {
+        if ((propagator ? propagator->value(v) : value(v)) == l_Undef)
+            return false;
+        assert(!lock || propagator == NULL);
+        if (lock) lock_reason(v);
+        return true;
+    }
+
     void clear_locked() { list_reason.clear(); }
     void undo_locked() { 
         for (int i = 0; i < list_reason.size(); i++) {
@@ -179,6 +219,10 @@ public:
         output.copyTo(outputs[outputs.size()-1]);
     }
 
+    // Job of a split run: the split variables and the cube over them
+    void insertSplit(vec<Lit> &split) { split.copyTo(job_split); }
+    void insertCube(vec<Lit> &cube) { cube.copyTo(job_cube); }
+
     void loadIO(vec<Lit>& in){
         for (int i = 0; i < inputs.size(); i++){
             for (int j = 0; j < inputs[i].size(); j++)
@@ -239,6 +283,26 @@ public:
         return vars;
     }
 
+    // Copies variables, units, clauses and IO into an empty solver (no selectors)
+    void cloneSolver(Solver &s){
+        cancelUntil(0);
+        s.cancelUntil(0);
+        if (!ok) s.addEmptyClause();
+        while (s.nVars() < nVars()) {
+            Var v = s.newVar();
+            if (assigns[v] != l_Undef)
+                s.addClause(mkLit(v, assigns[v] == l_False));
+        }
+
+        vec<Lit> clause;
+        for (int i = 0; i < nClauses(); i++) {
+            clause.clear();
+            getClause(i, clause);
+            s.addClause(clause);
+        }
+        copyIO(s);
+    }
+
     void getClause(int i , vec<Lit>& clause) {
         assert (i < nClauses());
         Clause &c = ca[clauses[i]];
@@ -247,9 +311,18 @@ public:
         }        
     }
 
-    vec<Lit>& getTrail() { return trail; }
+    // Literals assigned at the root level (unit clauses)
+    void getUnits(vec<Lit>& units) {
+        cancelUntil(0);
+        for (int i = 0; i < trail.size(); i++)
+            units.push(trail[i]);
+    }
+
+    const vec<Lit>& getTrail() const { return propagator ? propagator->getTrail() : trail; }
     vec<vec<Lit> >& getInputs() { return inputs; }
     vec<vec<Lit> >& getOutputs() { return outputs; }
+    vec<Lit>& getSplit() { return job_split; }
+    vec<Lit>& getCube() { return job_cube; }
     void setAssumptions(int v) { assumption_vars = v; }
 
     // Problem specification:
@@ -273,7 +346,7 @@ public:
     bool    solve        (Lit p, Lit q);            // Search for a model that respects two assumptions.
     bool    solve        (Lit p, Lit q, Lit r);     // Search for a model that respects three assumptions.
     bool    okay         () const;                  // FALSE means solver is in a conflicting state
-    bool    up           (const vec<Lit>& assumps); // Unit propagate from a given set of assumptions
+    bool    up           (const vec<Lit>& assumps); // Unit propagate from a given set of assumptions (reuses the common prefix)
 
     void    toDimacs     (FILE* f, const vec<Lit>& assumps);            // Write CNF to file in DIMACS-format.
     void    toDimacs     (const char *file, const vec<Lit>& assumps);
@@ -355,8 +428,21 @@ protected:
     //
     vec<vec<Lit> > inputs;
     vec<vec<Lit> > outputs;
+    vec<Lit> job_split;
+    vec<Lit> job_cube;
     int assumption_vars;
     vec<CRef> list_reason;
+    bool up_conflict;                     // The last call to 'up' stopped on a conflict.
+    bool subsume;                         // 'addClause__' performs subsumption.
+    vec<vec<CRef> > occs;                 // Problem clauses containing each literal (when 'subsume').
+    vec<char> subsume_mark;               // Literals of the clause being added (when 'subsume').
+    int n_subsumed;                       // Clauses rejected, removed or strengthened.
+    Propagator *propagator;               // Serves 'up' (when 'setPropagator').
+
+    bool addClauseSubsume(vec<Lit>& ps, vec<vec<Lit> >* out);
+    void attachOccs(CRef cr);
+    void removeSubsumed(CRef cr);
+    int  countMarked(const Clause& c) const;
 
     // Helper structures:
     //
@@ -395,6 +481,8 @@ protected:
     double              var_inc;          // Amount to bump next variable with.
     OccLists<Lit, vec<Watcher>, WatcherDeleted>
                         watches;          // 'watches[lit]' is a list of constraints watching 'lit' (will go there if literal becomes true).
+    OccLists<Lit, vec<Watcher>, WatcherDeleted>
+                        learnt_watches;   // Same as 'watches' for learnt clauses (not visited by 'up').
     vec<lbool>          assigns;          // The current assignments.
     vec<char>           polarity;         // The preferred polarity of each variable.
     vec<char>           decision;         // Declares if a variable is eligible for selection in the decision heuristic.
@@ -436,7 +524,7 @@ protected:
     void     newDecisionLevel ();                                                      // Begins a new decision level.
     void     uncheckedEnqueue (Lit p, CRef from = CRef_Undef);                         // Enqueue a literal. Assumes value of literal is undefined.
     bool     enqueue          (Lit p, CRef from = CRef_Undef);                         // Test if fact 'p' contradicts current state, enqueue otherwise.
-    CRef     propagate        ();                                                      // Perform unit propagation. Returns possibly conflicting clause.
+    CRef     propagate        (bool use_learnts = true);                               // Perform unit propagation. Returns possibly conflicting clause.
     void     analyze          (CRef confl, vec<Lit>& out_learnt, int& out_btlevel);    // (bt = backtrack)
     void     analyzeFinal     (Lit p, vec<Lit>& out_conflict);                         // COULD THIS BE IMPLEMENTED BY THE ORDINARIY "analyze" BY SOME REASONABLE GENERALIZATION?
     bool     litRedundant     (Lit p, uint32_t abstract_levels);                       // (helper method for 'analyze()')
@@ -56,6 +56,9 @@ class RegionAllocator
     uint32_t size      () const      { return sz; }
     uint32_t wasted    () const      { return wasted_; }
 
+    // Frees every allocation but keeps the memory of the region
+    void     clear     ()            { sz = 0; wasted_ = 0; }
+
     Ref      alloc     (int size); 
     void     free      (int size)    { wasted_ += size; }
 